@@ -0,0 +1,297 @@
+/**
+ * Host benchmark of the packsopener actions as the inventory grows
+ *
+ * For every size the chain is reset and filled through the public actions: size poolhalls assets
+ * bundled into packs with genpacks, size pending unboxes received through the transfer notification
+ * and size staked avatars. Each action is then called ROUNDS times on top of that state and the
+ * average wall time, db reads and writes, secondary index seeks, bytes allocated and inline actions
+ * per call are printed as a table and as JSON.
+ *
+ * Usage: actions_bench [--json <file>] [size...]
+ * Sizes default to 1000 10000 100000. Without --json the JSON report follows the table on stdout.
+ *
+ * Bytes allocated include the host stand-ins, such as the copy of every inline action that is
+ * captured, so they are only comparable between runs of this benchmark.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <packsopener.hpp>
+
+static uint64_t allocated_bytes = 0;
+
+//Every form of new and delete goes through this pair, so blocks are always allocated and released
+//the same way. They are kept out of line, otherwise the compiler sees free() on the result of new
+__attribute__((noinline)) static void *counted_malloc(size_t size) {
+    allocated_bytes += size;
+    if (void *ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) static void counted_free(void *ptr) noexcept {
+    free(ptr);
+}
+
+void *operator new(size_t size) {
+    return counted_malloc(size);
+}
+
+void *operator new[](size_t size) {
+    return counted_malloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    counted_free(ptr);
+}
+
+static const name SELF = CONTRACTN;
+static const name ORNG = name("orng.wax");
+static const name COLLECTION = name("clashdomenft");
+static const int32_t PACK_TEMPLATE_ID = 100001;
+static const int32_t AVATAR_TEMPLATE_ID = 336214;
+
+static const uint64_t ROUNDS = 100;
+static const uint64_t GEN_BATCH = 100;
+
+//Asset id ranges, so genpacks meets the poolhalls assets first and the packs after them
+static const uint64_t CONTENT_FIRST_ID = 1;
+static const uint64_t PACK_FIRST_ID = 1ULL << 40;
+static const uint64_t AVATAR_FIRST_ID = 1ULL << 41;
+
+struct result {
+    uint64_t    size;
+    string      action_name;
+    uint64_t    calls;
+    double      wall_us;
+    double      db_reads;
+    double      db_writes;
+    double      secondary_seeks;
+    double      bytes_allocated;
+    double      inline_actions;
+};
+
+static vector <result> results;
+
+//Distinct valid account names: "bench" followed by the index in base 26
+static name account(uint64_t index) {
+    string str = "bench";
+    for (int i = 0; i < 7; i++) {
+        str += (char) ('a' + index % 26);
+        index /= 26;
+    }
+    return name(str);
+}
+
+static void add_asset(uint64_t asset_id, name schema_name, int32_t template_id) {
+    atomicassets::assets_t own_assets = atomicassets::get_assets(SELF);
+    own_assets.emplace(SELF, [&](auto &_asset) {
+        _asset.asset_id = asset_id;
+        _asset.collection_name = COLLECTION;
+        _asset.schema_name = schema_name;
+        _asset.template_id = template_id;
+        _asset.ram_payer = SELF;
+    });
+}
+
+static checksum256 random_value(uint64_t seed) {
+    return eosio::sha256((const char *) &seed, sizeof(seed));
+}
+
+/**
+* Calls run(round) ROUNDS times and records the average cost of one call
+*/
+template <typename F>
+static void measure(uint64_t size, const string &action_name, F &&run) {
+    auto &chain = host::get_chain();
+    chain.reset_counters();
+    uint64_t bytes_before = allocated_bytes;
+
+    auto start = chrono::steady_clock::now();
+    for (uint64_t round = 0; round < ROUNDS; round++) {
+        run(round);
+    }
+    auto elapsed = chrono::duration_cast <chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+
+    double calls = (double) ROUNDS;
+    results.push_back({
+        size,
+        action_name,
+        ROUNDS,
+        (double) elapsed / 1000.0 / calls,
+        (double) chain.stats.db_reads / calls,
+        (double) chain.stats.db_writes / calls,
+        (double) chain.stats.secondary_seeks / calls,
+        (double) (allocated_bytes - bytes_before) / calls,
+        (double) chain.stats.inline_actions / calls
+    });
+    chain.reset_counters();
+}
+
+static void run_size(uint64_t size) {
+    auto &chain = host::get_chain();
+    chain.reset();
+
+    packsopener opener(SELF, SELF, datastream <const char *>(nullptr, 0));
+
+    atomicassets::collections.emplace(SELF, [&](auto &_collection) {
+        _collection.collection_name = COLLECTION;
+        _collection.author = SELF;
+        _collection.authorized_accounts = {SELF};
+    });
+
+    chain.set_auth({SELF});
+    opener.createpack(SELF, COLLECTION, 0, PACK_TEMPLATE_ID, "");
+    uint64_t pack_id = 1;
+
+    //Inventory: size single asset bundles, then the assets picked up by the genpacks rounds
+    //and the ones bundled by the addpack rounds
+    for (uint64_t i = 0; i < size + GEN_BATCH * ROUNDS + ROUNDS; i++) {
+        add_asset(CONTENT_FIRST_ID + i, name("poolhalls"), -1);
+    }
+    chain.set_auth({SELF});
+    opener.genpacks(SELF, PACK_TEMPLATE_ID, size);
+
+    //Pending unboxes of size accounts, the rounds unbox further packs of their own
+    for (uint64_t i = 0; i < size + ROUNDS; i++) {
+        add_asset(PACK_FIRST_ID + i, name("packs"), PACK_TEMPLATE_ID);
+    }
+    chain.set_auth({});
+    for (uint64_t i = 0; i < size; i++) {
+        opener.receive_asset_transfer(account(i), SELF, {PACK_FIRST_ID + i}, "unbox");
+    }
+
+    //Staked avatars of size accounts
+    for (uint64_t i = 0; i < size + ROUNDS; i++) {
+        add_asset(AVATAR_FIRST_ID + i, name("packs"), AVATAR_TEMPLATE_ID);
+    }
+    for (uint64_t i = 0; i < size; i++) {
+        opener.receive_asset_transfer(account(i), SELF, {AVATAR_FIRST_ID + i}, "unbox avatar");
+    }
+    chain.reset_counters();
+
+    measure(size, "genpacks", [&](uint64_t) {
+        chain.set_auth({SELF});
+        opener.genpacks(SELF, PACK_TEMPLATE_ID, GEN_BATCH);
+    });
+
+    measure(size, "addpack", [&](uint64_t round) {
+        chain.set_auth({SELF});
+        opener.addpack(pack_id, {CONTENT_FIRST_ID + size + GEN_BATCH * ROUNDS + round});
+    });
+
+    uint64_t unboxer_offset = size;
+    measure(size, "transfer unbox", [&](uint64_t round) {
+        chain.set_auth({});
+        opener.receive_asset_transfer(account(unboxer_offset + round), SELF, {PACK_FIRST_ID + size + round}, "unbox");
+    });
+
+    measure(size, "receiverand", [&](uint64_t round) {
+        chain.set_auth({ORNG});
+        opener.receiverand(PACK_FIRST_ID + size + round, random_value(round));
+    });
+
+    measure(size, "claimunboxed", [&](uint64_t round) {
+        chain.set_auth({account(unboxer_offset + round)});
+        opener.claimunboxed(PACK_FIRST_ID + size + round);
+    });
+
+    measure(size, "transfer unbox avatar", [&](uint64_t round) {
+        chain.set_auth({});
+        opener.receive_asset_transfer(account(unboxer_offset + round), SELF, {AVATAR_FIRST_ID + size + round}, "unbox avatar");
+    });
+
+    measure(size, "claimavatar", [&](uint64_t round) {
+        chain.set_auth({account(unboxer_offset + round)});
+        opener.claimavatar(account(unboxer_offset + round), AVATAR_FIRST_ID + size + round);
+    });
+
+    measure(size, "createavatar", [&](uint64_t round) {
+        chain.set_auth({SELF});
+        opener.createavatar(account(unboxer_offset + round), AVATAR_FIRST_ID + size + round, AVATAR_TEMPLATE_ID);
+    });
+}
+
+static void print_table(FILE *out) {
+    fprintf(out, "%8s  %-22s %6s %10s %10s %10s %10s %12s %8s\n",
+        "size", "action", "calls", "wall us", "db reads", "db writes", "sec seeks", "bytes alloc", "inline");
+    for (const auto &r : results) {
+        fprintf(out, "%8llu  %-22s %6llu %10.2f %10.1f %10.1f %10.1f %12.0f %8.1f\n",
+            (unsigned long long) r.size, r.action_name.c_str(), (unsigned long long) r.calls,
+            r.wall_us, r.db_reads, r.db_writes, r.secondary_seeks, r.bytes_allocated, r.inline_actions);
+    }
+}
+
+static void print_json(FILE *out) {
+    fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        fprintf(out, "  {\"size\": %llu, \"action\": \"%s\", \"calls\": %llu, \"wall_us\": %.3f, "
+            "\"db_reads\": %.2f, \"db_writes\": %.2f, \"secondary_seeks\": %.2f, "
+            "\"bytes_allocated\": %.1f, \"inline_actions\": %.2f}%s\n",
+            (unsigned long long) r.size, r.action_name.c_str(), (unsigned long long) r.calls,
+            r.wall_us, r.db_reads, r.db_writes, r.secondary_seeks, r.bytes_allocated, r.inline_actions,
+            i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = nullptr;
+    vector <uint64_t> sizes;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            sizes.push_back(strtoull(argv[i], nullptr, 10));
+        }
+    }
+    if (sizes.empty()) {
+        sizes = {1000, 10000, 100000};
+    }
+
+    try {
+        for (uint64_t size : sizes) {
+            run_size(size);
+        }
+    } catch (const host::assert_exception &e) {
+        fprintf(stderr, "assertion failed: %s\n", e.what());
+        return 1;
+    }
+
+    print_table(stdout);
+
+    if (json_path) {
+        FILE *json = fopen(json_path, "w");
+        if (!json) {
+            fprintf(stderr, "cannot open %s\n", json_path);
+            return 1;
+        }
+        print_json(json);
+        fclose(json);
+    } else {
+        printf("\n");
+        print_json(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * Host benchmark of the base58 codec used for ipfs attributes
+ *
+ * Encodes and decodes random 34 byte CIDv0 multihashes with the generic Bitcoin codec
+ * and with the fixed size IPFS hash codec, checks that both agree and prints the time per call.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base58.hpp"
+
+using namespace std;
+
+static const int HASH_COUNT = 2000;
+static const int ROUNDS = 50;
+
+template <typename F>
+double ns_per_call(F &&run) {
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; round++) {
+        run();
+    }
+    auto elapsed = chrono::duration_cast <chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return (double) elapsed / ((double) ROUNDS * HASH_COUNT);
+}
+
+int main() {
+    mt19937_64 rng(42);
+
+    //CIDv0: sha2-256 code, 32 byte length and the digest
+    vector <vector <unsigned char>> hashes(HASH_COUNT, vector <unsigned char>(IPFS_HASH_BYTES));
+    for (auto &hash : hashes) {
+        hash[0] = 0x12;
+        hash[1] = 0x20;
+        for (int i = 2; i < IPFS_HASH_BYTES; i++) {
+            hash[i] = (unsigned char) rng();
+        }
+    }
+    //Also check inputs with leading zero bytes, which the fast path has to map to leading '1's
+    for (int i = 0; i < 8; i++) {
+        for (int zero = 0; zero <= i * 4 && zero < IPFS_HASH_BYTES; zero++) {
+            hashes[i][zero] = 0;
+        }
+    }
+
+    vector <string> encoded(HASH_COUNT);
+    for (int i = 0; i < HASH_COUNT; i++) {
+        encoded[i] = EncodeBase58Generic(hashes[i].data(), hashes[i].data() + IPFS_HASH_BYTES);
+
+        string fast = EncodeBase58Hash(hashes[i].data());
+        vector <unsigned char> generic_decoded, fast_decoded;
+        bool generic_ok = DecodeBase58Generic(encoded[i].c_str(), generic_decoded);
+        bool fast_ok = encoded[i].size() != IPFS_HASH_CHARS || DecodeBase58Hash(encoded[i].c_str(), fast_decoded);
+        if (fast != encoded[i] || !generic_ok || !fast_ok || generic_decoded != hashes[i]
+            || (encoded[i].size() == IPFS_HASH_CHARS && fast_decoded != hashes[i])) {
+            printf("mismatch for hash %d: %s / %s\n", i, encoded[i].c_str(), fast.c_str());
+            return 1;
+        }
+    }
+
+    size_t sink = 0;
+    double encode_generic = ns_per_call([&]() {
+        for (const auto &hash : hashes) {
+            sink += EncodeBase58Generic(hash.data(), hash.data() + IPFS_HASH_BYTES).size();
+        }
+    });
+    double encode_fast = ns_per_call([&]() {
+        for (const auto &hash : hashes) {
+            sink += EncodeBase58(hash).size();
+        }
+    });
+
+    vector <unsigned char> decoded;
+    double decode_generic = ns_per_call([&]() {
+        for (const auto &str : encoded) {
+            DecodeBase58Generic(str.c_str(), decoded);
+            sink += decoded.size();
+        }
+    });
+    double decode_fast = ns_per_call([&]() {
+        for (const auto &str : encoded) {
+            DecodeBase58(str, decoded);
+            sink += decoded.size();
+        }
+    });
+
+    printf("%-8s %12s %12s %8s\n", "", "generic ns", "ipfs ns", "speedup");
+    printf("%-8s %12.1f %12.1f %7.1fx\n", "encode", encode_generic, encode_fast, encode_generic / encode_fast);
+    printf("%-8s %12.1f %12.1f %7.1fx\n", "decode", decode_generic, decode_fast, decode_generic / decode_fast);
+    printf("(checksum %zu)\n", sink);
+    return 0;
+}
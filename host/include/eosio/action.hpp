@@ -0,0 +1,41 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include <host/chain.hpp>
+#include <eosio/name.hpp>
+
+namespace eosio {
+
+    struct permission_level {
+        permission_level(name a, name p) : actor(a), permission(p) {}
+        permission_level() = default;
+
+        name actor;
+        name permission;
+    };
+
+    /**
+    * Inline actions are not executed on the host, send() only records them
+    * in host::chain::actions together with their arguments
+    */
+    struct action {
+        template <typename T>
+        action(const permission_level &auth, name a, name n, T &&value)
+            : authorization(auth), account(a), name(n),
+            data(std::make_any<std::decay_t<T>>(std::forward<T>(value))) {}
+
+        void send() const {
+            auto &chain = host::get_chain();
+            chain.stats.inline_actions++;
+            chain.actions.push_back({authorization.actor, authorization.permission, account, name, data});
+        }
+
+        permission_level authorization;
+        eosio::name      account;
+        eosio::name      name;
+        std::any         data;
+    };
+
+} // namespace eosio
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include <eosio/name.hpp>
+
+namespace eosio {
+
+    class symbol {
+    public:
+        constexpr symbol() = default;
+        constexpr explicit symbol(uint64_t raw) : _value(raw) {}
+
+        constexpr uint64_t raw() const { return _value; }
+        constexpr uint8_t precision() const { return uint8_t(_value & 0xFF); }
+
+        friend constexpr bool operator==(const symbol &a, const symbol &b) { return a._value == b._value; }
+        friend constexpr bool operator!=(const symbol &a, const symbol &b) { return a._value != b._value; }
+
+    private:
+        uint64_t _value = 0;
+    };
+
+    struct extended_symbol {
+        symbol sym;
+        name   contract;
+    };
+
+    struct asset {
+        int64_t amount = 0;
+        eosio::symbol symbol;
+    };
+
+} // namespace eosio
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <host/chain.hpp>
+#include <eosio/name.hpp>
+
+// Contract attributes are only meaningful to eosio-cpp
+#define CONTRACT class
+#define ACTION void
+#define TABLE struct
+
+namespace eosio {
+
+    inline void check(bool pred, const char *msg) {
+        if (!pred) {
+            throw host::assert_exception(msg);
+        }
+    }
+
+    inline void check(bool pred, const std::string &msg) {
+        if (!pred) {
+            throw host::assert_exception(msg);
+        }
+    }
+
+    inline void require_auth(name account) {
+        check(host::get_chain().authorizers.count(account.value) > 0,
+            "missing authority of " + account.to_string());
+    }
+
+    inline bool has_auth(name account) {
+        return host::get_chain().authorizers.count(account.value) > 0;
+    }
+
+    template <typename... Args>
+    void print(Args &&... args) {
+        (std::cout << ... << args);
+    }
+
+    template <typename T>
+    class datastream {
+    public:
+        datastream(T start, size_t size) : _start(start), _pos(start), _end(start + size) {}
+
+    private:
+        T _start;
+        T _pos;
+        T _end;
+    };
+
+    class contract {
+    public:
+        contract(name self, name first_receiver, datastream<const char *> ds)
+            : _self(self), _first_receiver(first_receiver), _ds(ds) {}
+
+        inline name get_self() const { return _self; }
+        inline name get_first_receiver() const { return _first_receiver; }
+
+    protected:
+        name _self;
+        name _first_receiver;
+        datastream<const char *> _ds;
+    };
+
+} // namespace eosio
+
+#include <eosio/system.hpp>
+#include <eosio/action.hpp>
+#include <eosio/multi_index.hpp>
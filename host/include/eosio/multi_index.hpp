@@ -0,0 +1,369 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <host/chain.hpp>
+#include <eosio/name.hpp>
+
+namespace eosio {
+
+    template <name::raw IndexName, typename Extractor>
+    struct indexed_by {
+        static constexpr name index_name = name(IndexName);
+        typedef Extractor secondary_extractor_type;
+    };
+
+    template <class Class, typename Type, Type (Class::*PtrToMemberFunction)() const>
+    struct const_mem_fun {
+        typedef typename std::remove_reference<Type>::type result_type;
+
+        result_type operator()(const Class &c) const {
+            return (c.*PtrToMemberFunction)();
+        }
+    };
+
+    namespace detail {
+
+        /**
+        * Rows of one (code, scope, table) triple plus one sorted (secondary key, primary key)
+        * set per secondary index. Every multi_index object that names the same triple shares it.
+        */
+        template <typename T, typename... Indices>
+        struct table_storage {
+            static constexpr size_t index_count = sizeof...(Indices);
+
+            typedef std::set <std::pair <uint64_t, uint64_t>> secondary_t;
+
+            std::map <uint64_t, T>                 rows;
+            std::array <secondary_t, index_count>  secondary;
+
+            template <size_t I>
+            static uint64_t secondary_key(const T &row) {
+                typedef typename std::tuple_element <I, std::tuple <Indices...>>::type index_type;
+                typedef typename index_type::secondary_extractor_type extractor_type;
+                static_assert(std::is_same <typename extractor_type::result_type, uint64_t>::value,
+                    "the host multi_index only supports uint64_t secondary keys");
+                return extractor_type()(row);
+            }
+
+            template <size_t... I>
+            void insert_secondary(const T &row, std::index_sequence <I...>) {
+                (secondary[I].insert({secondary_key <I>(row), row.primary_key()}), ...);
+            }
+
+            template <size_t... I>
+            void erase_secondary(const T &row, std::index_sequence <I...>) {
+                (secondary[I].erase({secondary_key <I>(row), row.primary_key()}), ...);
+            }
+
+            void insert_secondary(const T &row) { insert_secondary(row, std::index_sequence_for <Indices...>()); }
+            void erase_secondary(const T &row) { erase_secondary(row, std::index_sequence_for <Indices...>()); }
+        };
+
+        template <typename Storage>
+        std::shared_ptr <Storage> open_storage(uint64_t code, uint64_t scope, uint64_t table) {
+            auto &slot = host::get_chain().tables[host::table_id{code, scope, table}];
+            if (!slot.storage) {
+                auto storage = std::make_shared <Storage>();
+                slot.storage = storage;
+                slot.clear = [storage]() {
+                    storage->rows.clear();
+                    for (auto &index : storage->secondary) {
+                        index.clear();
+                    }
+                };
+            }
+            return std::static_pointer_cast <Storage>(slot.storage);
+        }
+
+    } // namespace detail
+
+    /**
+    * Host stand-in for eosio::multi_index backed by std::map
+    *
+    * Iterators stay valid until the row they point to is erased, like on chain.
+    * Every primary lookup or iterator step counts as one db read, every emplace, modify
+    * or erase as one db write and every secondary lower/upper bound as one secondary seek.
+    */
+    template <name::raw TableName, typename T, typename... Indices>
+    class multi_index {
+    public:
+        typedef detail::table_storage <T, Indices...> storage_t;
+        typedef typename std::map <uint64_t, T>::const_iterator row_iterator;
+
+        class const_iterator {
+        public:
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef const T                         value_type;
+            typedef std::ptrdiff_t                  difference_type;
+            typedef const T *                       pointer;
+            typedef const T &                       reference;
+
+            const_iterator() = default;
+            const_iterator(const storage_t *storage, row_iterator itr) : _storage(storage), _itr(itr) {}
+
+            const T &operator*() const {
+                check(_itr != _storage->rows.end(), "cannot dereference end iterator");
+                return _itr->second;
+            }
+
+            const T *operator->() const { return &**this; }
+
+            const_iterator &operator++() {
+                host::get_chain().stats.db_reads++;
+                check(_itr != _storage->rows.end(), "cannot increment end iterator");
+                ++_itr;
+                return *this;
+            }
+
+            const_iterator &operator--() {
+                host::get_chain().stats.db_reads++;
+                check(_itr != _storage->rows.begin(), "cannot decrement iterator at beginning of table");
+                --_itr;
+                return *this;
+            }
+
+            const_iterator operator++(int) { const_iterator copy = *this; ++*this; return copy; }
+            const_iterator operator--(int) { const_iterator copy = *this; --*this; return copy; }
+
+            friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._itr == b._itr; }
+            friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._itr != b._itr; }
+
+        private:
+            friend class multi_index;
+
+            const storage_t *_storage = nullptr;
+            row_iterator     _itr;
+        };
+
+        typedef std::reverse_iterator <const_iterator> const_reverse_iterator;
+
+        template <size_t I>
+        class index {
+        public:
+            typedef typename storage_t::secondary_t::const_iterator key_iterator;
+
+            class const_iterator {
+            public:
+                typedef std::bidirectional_iterator_tag iterator_category;
+                typedef const T                         value_type;
+                typedef std::ptrdiff_t                  difference_type;
+                typedef const T *                       pointer;
+                typedef const T &                       reference;
+
+                const_iterator() = default;
+                const_iterator(const storage_t *storage, key_iterator itr) : _storage(storage), _itr(itr) {}
+
+                const T &operator*() const {
+                    check(_itr != _storage->secondary[I].end(), "cannot dereference end iterator");
+                    return _storage->rows.at(_itr->second);
+                }
+
+                const T *operator->() const { return &**this; }
+
+                const_iterator &operator++() {
+                    host::get_chain().stats.db_reads++;
+                    ++_itr;
+                    return *this;
+                }
+
+                const_iterator &operator--() {
+                    host::get_chain().stats.db_reads++;
+                    --_itr;
+                    return *this;
+                }
+
+                const_iterator operator++(int) { const_iterator copy = *this; ++*this; return copy; }
+                const_iterator operator--(int) { const_iterator copy = *this; --*this; return copy; }
+
+                friend bool operator==(const const_iterator &a, const const_iterator &b) { return a._itr == b._itr; }
+                friend bool operator!=(const const_iterator &a, const const_iterator &b) { return a._itr != b._itr; }
+
+            private:
+                friend class index;
+
+                const storage_t *_storage = nullptr;
+                key_iterator     _itr;
+            };
+
+            explicit index(multi_index *table) : _table(table) {}
+
+            const_iterator begin() const { return {storage(), keys().begin()}; }
+            const_iterator end() const { return {storage(), keys().end()}; }
+
+            const_iterator lower_bound(uint64_t key) const {
+                host::get_chain().stats.secondary_seeks++;
+                return {storage(), keys().lower_bound({key, 0})};
+            }
+
+            const_iterator upper_bound(uint64_t key) const {
+                host::get_chain().stats.secondary_seeks++;
+                return {storage(), keys().upper_bound({key, std::numeric_limits <uint64_t>::max()})};
+            }
+
+            const_iterator find(uint64_t key) const {
+                auto itr = lower_bound(key);
+                if (itr != end() && itr._itr->first != key) {
+                    return end();
+                }
+                return itr;
+            }
+
+            const_iterator require_find(uint64_t key, const char *error_msg = "unable to find secondary key") const {
+                auto itr = find(key);
+                check(itr != end(), error_msg);
+                return itr;
+            }
+
+            const T &get(uint64_t key, const char *error_msg = "unable to find secondary key") const {
+                return *require_find(key, error_msg);
+            }
+
+            const_iterator iterator_to(const T &obj) const {
+                return {storage(), keys().find({storage_t::template secondary_key <I>(obj), obj.primary_key()})};
+            }
+
+            template <typename Lambda>
+            void modify(const_iterator itr, name payer, Lambda &&updater) {
+                _table->modify(_table->find(itr->primary_key()), payer, std::forward <Lambda>(updater));
+            }
+
+            const_iterator erase(const_iterator itr) {
+                check(itr != end(), "cannot pass end iterator to erase");
+                auto next = itr;
+                ++next;
+                uint64_t next_primary = next == end() ? 0 : next._itr->second;
+                bool at_end = next == end();
+                _table->erase(_table->find(itr->primary_key()));
+                return at_end ? end() : iterator_to(storage()->rows.at(next_primary));
+            }
+
+        private:
+            const storage_t *storage() const { return _table->_storage.get(); }
+            const typename storage_t::secondary_t &keys() const { return _table->_storage->secondary[I]; }
+
+            multi_index *_table;
+        };
+
+        multi_index(name code, uint64_t scope)
+            : _code(code), _scope(scope),
+            _storage(detail::open_storage <storage_t>(code.value, scope, static_cast <uint64_t>(TableName))) {}
+
+        name get_code() const { return _code; }
+        uint64_t get_scope() const { return _scope; }
+
+        const_iterator begin() const { return {_storage.get(), _storage->rows.begin()}; }
+        const_iterator end() const { return {_storage.get(), _storage->rows.end()}; }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+        const_iterator find(uint64_t primary) const {
+            host::get_chain().stats.db_reads++;
+            return {_storage.get(), _storage->rows.find(primary)};
+        }
+
+        const_iterator require_find(uint64_t primary, const char *error_msg = "unable to find key") const {
+            auto itr = find(primary);
+            check(itr != end(), error_msg);
+            return itr;
+        }
+
+        const T &get(uint64_t primary, const char *error_msg = "unable to find key") const {
+            return *require_find(primary, error_msg);
+        }
+
+        const_iterator lower_bound(uint64_t primary) const {
+            host::get_chain().stats.db_reads++;
+            return {_storage.get(), _storage->rows.lower_bound(primary)};
+        }
+
+        const_iterator upper_bound(uint64_t primary) const {
+            host::get_chain().stats.db_reads++;
+            return {_storage.get(), _storage->rows.upper_bound(primary)};
+        }
+
+        const_iterator iterator_to(const T &obj) const {
+            return {_storage.get(), _storage->rows.find(obj.primary_key())};
+        }
+
+        uint64_t available_primary_key() const {
+            host::get_chain().stats.db_reads++;
+            if (_storage->rows.empty()) {
+                return 0;
+            }
+            return _storage->rows.rbegin()->first + 1;
+        }
+
+        template <size_t I = 0>
+        static constexpr size_t index_position(name index_name) {
+            if constexpr (I < sizeof...(Indices)) {
+                typedef typename std::tuple_element <I, std::tuple <Indices...>>::type index_type;
+                return index_type::index_name == index_name ? I : index_position <I + 1>(index_name);
+            } else {
+                return sizeof...(Indices);
+            }
+        }
+
+        template <name::raw IndexName>
+        auto get_index() {
+            constexpr size_t position = index_position(name(IndexName));
+            static_assert(position < sizeof...(Indices), "name provided is not the name of any secondary index");
+            return index <position>(this);
+        }
+
+        template <typename Lambda>
+        const_iterator emplace(name payer, Lambda &&constructor) {
+            host::get_chain().stats.db_writes++;
+            T row{};
+            constructor(row);
+            uint64_t primary = row.primary_key();
+            check(_storage->rows.count(primary) == 0, "could not insert object, most likely a uniqueness constraint was violated");
+            auto inserted = _storage->rows.emplace(primary, std::move(row)).first;
+            _storage->insert_secondary(inserted->second);
+            return {_storage.get(), inserted};
+        }
+
+        template <typename Lambda>
+        void modify(const_iterator itr, name payer, Lambda &&updater) {
+            host::get_chain().stats.db_writes++;
+            check(itr != end(), "cannot pass end iterator to modify");
+            T &row = _storage->rows.at(itr->primary_key());
+            uint64_t primary = row.primary_key();
+            _storage->erase_secondary(row);
+            updater(row);
+            check(primary == row.primary_key(), "updater cannot change primary key when modifying an object");
+            _storage->insert_secondary(row);
+        }
+
+        template <typename Lambda>
+        void modify(const T &obj, name payer, Lambda &&updater) {
+            modify(iterator_to(obj), payer, std::forward <Lambda>(updater));
+        }
+
+        const_iterator erase(const_iterator itr) {
+            host::get_chain().stats.db_writes++;
+            check(itr != end(), "cannot pass end iterator to erase");
+            _storage->erase_secondary(itr._itr->second);
+            return {_storage.get(), _storage->rows.erase(itr._itr)};
+        }
+
+        void erase(const T &obj) {
+            erase(iterator_to(obj));
+        }
+
+    private:
+        name                        _code;
+        uint64_t                    _scope;
+        std::shared_ptr <storage_t> _storage;
+    };
+
+} // namespace eosio
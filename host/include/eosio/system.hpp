@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include <host/chain.hpp>
+
+namespace eosio {
+
+    class time_point {
+    public:
+        explicit time_point(int64_t us = 0) : _us(us) {}
+
+        int64_t time_since_epoch() const { return _us; }
+        uint32_t sec_since_epoch() const { return uint32_t(_us / 1000000); }
+
+    private:
+        int64_t _us;
+    };
+
+    inline time_point current_time_point() {
+        return time_point(int64_t(host::get_chain().now_sec) * 1000000);
+    }
+
+} // namespace eosio
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstring>
+
+#include <host/chain.hpp>
+
+namespace eosio {
+
+    inline size_t transaction_size() {
+        return host::get_chain().transaction.size();
+    }
+
+    inline size_t read_transaction(char *buffer, size_t size) {
+        auto &transaction = host::get_chain().transaction;
+        size_t copied = std::min(size, transaction.size());
+        std::memcpy(buffer, transaction.data(), copied);
+        return copied;
+    }
+
+} // namespace eosio
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <eosio/name.hpp>
+
+/**
+* In-memory chain state shared by the host stand-ins of the eosio headers
+*
+* There is exactly one chain per process. Tests and benchmarks drive it directly:
+* set the authorizers and the clock, call contract actions, then inspect the
+* inline actions that were captured and the database counters.
+* There is no transaction rollback: a failed check leaves every write made before it in place.
+*/
+namespace host {
+
+    struct assert_exception : public std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    struct sent_action {
+        eosio::name actor;
+        eosio::name permission;
+        eosio::name account;
+        eosio::name action_name;
+        std::any    data;
+
+        template <typename T>
+        const T &as() const { return std::any_cast<const T &>(data); }
+    };
+
+    struct counters {
+        uint64_t db_reads       = 0;    // primary finds, lower/upper bounds and iterator steps
+        uint64_t db_writes      = 0;    // emplace, modify and erase
+        uint64_t secondary_seeks = 0;   // secondary index finds, lower/upper bounds
+        uint64_t inline_actions = 0;
+        uint64_t sha256_bytes   = 0;
+    };
+
+    struct table_id {
+        uint64_t code;
+        uint64_t scope;
+        uint64_t table;
+
+        bool operator<(const table_id &other) const {
+            return std::tie(code, scope, table) < std::tie(other.code, other.scope, other.table);
+        }
+    };
+
+    //Storage of one table and how to empty it without knowing its row type
+    struct table_slot {
+        std::shared_ptr<void>   storage;
+        std::function<void()>   clear;
+    };
+
+    struct chain {
+        std::set<uint64_t>                           authorizers;
+        uint32_t                                     now_sec = 0;
+        std::vector<char>                            transaction = std::vector<char>(128, 0);
+        std::vector<sent_action>                     actions;
+        counters                                     stats;
+        std::map<table_id, table_slot>               tables;
+
+        void set_auth(std::initializer_list<eosio::name> accounts) {
+            authorizers.clear();
+            for (auto account : accounts) {
+                authorizers.insert(account.value);
+            }
+        }
+
+        void reset_counters() {
+            stats = {};
+            actions.clear();
+        }
+
+        //Tables are emptied in place, so table objects that are still alive keep working
+        void reset() {
+            authorizers.clear();
+            actions.clear();
+            for (auto &table : tables) {
+                table.second.clear();
+            }
+            stats = {};
+        }
+    };
+
+    inline chain &get_chain() {
+        static chain instance;
+        return instance;
+    }
+
+} // namespace host
@@ -148,21 +148,21 @@ namespace atomicassets {
     typedef singleton <name("tokenconfigs"), tokenconfigs_s> tokenconfigs_t;
 
 
-    collections_t  collections  = collections_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
-    offers_t       offers       = offers_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
-    balances_t     balances     = balances_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
-    config_t       config       = config_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
-    tokenconfigs_t tokenconfigs = tokenconfigs_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    inline collections_t  collections  = collections_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    inline offers_t       offers       = offers_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    inline balances_t     balances     = balances_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    inline config_t       config       = config_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
+    inline tokenconfigs_t tokenconfigs = tokenconfigs_t(ATOMICASSETS_ACCOUNT, ATOMICASSETS_ACCOUNT.value);
 
-    assets_t get_assets(name acc) {
+    inline assets_t get_assets(name acc) {
         return assets_t(ATOMICASSETS_ACCOUNT, acc.value);
     }
 
-    schemas_t get_schemas(name collection_name) {
+    inline schemas_t get_schemas(name collection_name) {
         return schemas_t(ATOMICASSETS_ACCOUNT, collection_name.value);
     }
 
-    templates_t get_templates(name collection_name) {
+    inline templates_t get_templates(name collection_name) {
         return templates_t(ATOMICASSETS_ACCOUNT, collection_name.value);
     }
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <eosio/eosio.hpp>
+#include <optional>
+#include <string_view>
 #include "base58.hpp"
 
 using namespace eosio;
@@ -40,7 +42,7 @@ namespace atomicdata {
     static constexpr uint64_t RESERVED = 4;
 
 
-    vector <uint8_t> toVarintBytes(uint64_t number, uint64_t original_bytes = 8) {
+    inline vector <uint8_t> toVarintBytes(uint64_t number, uint64_t original_bytes = 8) {
         if (original_bytes < 8) {
             uint64_t bitmask = ((uint64_t) 1 << original_bytes * 8) - 1;
             number &= bitmask;
@@ -57,23 +59,8 @@ namespace atomicdata {
         return bytes;
     }
 
-    uint64_t unsignedFromVarintBytes(vector <const uint8_t>::iterator &itr) {
-        uint64_t number = 0;
-        uint64_t multiplier = 1;
-
-        while (*itr >= 128) {
-            number += (((uint64_t) * itr) - 128) * multiplier;
-            itr++;
-            multiplier *= 128;
-        }
-        number += ((uint64_t) * itr) * multiplier;
-        itr++;
-
-        return number;
-    }
-
     //It is expected that the number is smaller than 2^byte_amount
-    vector <uint8_t> toIntBytes(uint64_t number, uint64_t byte_amount) {
+    inline vector <uint8_t> toIntBytes(uint64_t number, uint64_t byte_amount) {
         vector <uint8_t> bytes = {};
         for (uint64_t i = 0; i < byte_amount; i++) {
             bytes.push_back((uint8_t) number % 256);
@@ -82,7 +69,7 @@ namespace atomicdata {
         return bytes;
     }
 
-    uint64_t unsignedFromIntBytes(vector <const uint8_t>::iterator &itr, uint64_t original_bytes = 8) {
+    inline uint64_t unsignedFromIntBytes(vector <uint8_t>::const_iterator &itr, uint64_t original_bytes = 8) {
         uint64_t number = 0;
         uint64_t multiplier = 1;
 
@@ -96,7 +83,7 @@ namespace atomicdata {
     }
 
 
-    uint64_t zigzagEncode(int64_t value) {
+    inline uint64_t zigzagEncode(int64_t value) {
         if (value < 0) {
             return (uint64_t)(-1 * (value + 1)) * 2 + 1;
         } else {
@@ -104,7 +91,7 @@ namespace atomicdata {
         }
     }
 
-    int64_t zigzagDecode(uint64_t value) {
+    inline int64_t zigzagDecode(uint64_t value) {
         if (value % 2 == 0) {
             return (int64_t)(value / 2);
         } else {
@@ -113,407 +100,930 @@ namespace atomicdata {
     }
 
 
-    vector <uint8_t> serialize_attribute(const string &type, const ATOMIC_ATTRIBUTE &attr) {
-        if (type.find("[]", type.length() - 2) == type.length() - 2) {
-            //Type is an array
-            string base_type = type.substr(0, type.length() - 2);
 
-            if (std::holds_alternative <INT8_VEC>(attr)) {
-                INT8_VEC vec = std::get <INT8_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <INT16_VEC>(attr)) {
-                INT16_VEC vec = std::get <INT16_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <INT32_VEC>(attr)) {
-                INT32_VEC vec = std::get <INT32_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <INT64_VEC>(attr)) {
-                INT64_VEC vec = std::get <INT64_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <UINT8_VEC>(attr)) {
-                UINT8_VEC vec = std::get <UINT8_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <UINT16_VEC>(attr)) {
-                UINT16_VEC vec = std::get <UINT16_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <UINT32_VEC>(attr)) {
-                UINT32_VEC vec = std::get <UINT32_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <UINT64_VEC>(attr)) {
-                UINT64_VEC vec = std::get <UINT64_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <FLOAT_VEC>(attr)) {
-                FLOAT_VEC vec = std::get <FLOAT_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <DOUBLE_VEC>(attr)) {
-                DOUBLE_VEC vec = std::get <DOUBLE_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
-
-            } else if (std::holds_alternative <STRING_VEC>(attr)) {
-                STRING_VEC vec = std::get <STRING_VEC>(attr);
-                vector <uint8_t> serialized_data = toVarintBytes(vec.size());
-                for (auto child : vec) {
-                    ATOMIC_ATTRIBUTE child_attr = child;
-                    vector <uint8_t> serialized_element = serialize_attribute(base_type, child_attr);
-                    serialized_data.insert(serialized_data.end(), serialized_element.begin(), serialized_element.end());
-                }
-                return serialized_data;
+    //Type tags of the attribute types, so that the type strings of a schema only need to be parsed once
+    enum ATTRIBUTE_TYPE : uint8_t {
+        TYPE_INT8, TYPE_INT16, TYPE_INT32, TYPE_INT64,
+        TYPE_UINT8, TYPE_UINT16, TYPE_UINT32, TYPE_UINT64,
+        TYPE_FIXED8, TYPE_FIXED16, TYPE_FIXED32, TYPE_FIXED64,
+        TYPE_FLOAT, TYPE_DOUBLE,
+        TYPE_STRING, TYPE_IMAGE, TYPE_IPFS,
+        TYPE_BOOL, TYPE_BYTE
+    };
+
+    struct COMPILED_TYPE {
+        ATTRIBUTE_TYPE type;
+        bool           is_array;
+    };
+
+    struct COMPILED_LINE {
+        std::string    name;
+        ATTRIBUTE_TYPE type;
+        bool           is_array;
+    };
+
+
+    inline COMPILED_TYPE compile_type(const string &type) {
+        bool is_array = type.length() >= 2 && type.find("[]", type.length() - 2) == type.length() - 2;
+        string base_type = is_array ? type.substr(0, type.length() - 2) : type;
+
+        ATTRIBUTE_TYPE tag = TYPE_STRING;
+        if (base_type == "int8") {
+            tag = TYPE_INT8;
+        } else if (base_type == "int16") {
+            tag = TYPE_INT16;
+        } else if (base_type == "int32") {
+            tag = TYPE_INT32;
+        } else if (base_type == "int64") {
+            tag = TYPE_INT64;
+        } else if (base_type == "uint8") {
+            tag = TYPE_UINT8;
+        } else if (base_type == "uint16") {
+            tag = TYPE_UINT16;
+        } else if (base_type == "uint32") {
+            tag = TYPE_UINT32;
+        } else if (base_type == "uint64") {
+            tag = TYPE_UINT64;
+        } else if (base_type == "fixed8") {
+            tag = TYPE_FIXED8;
+        } else if (base_type == "fixed16") {
+            tag = TYPE_FIXED16;
+        } else if (base_type == "fixed32") {
+            tag = TYPE_FIXED32;
+        } else if (base_type == "fixed64") {
+            tag = TYPE_FIXED64;
+        } else if (base_type == "float") {
+            tag = TYPE_FLOAT;
+        } else if (base_type == "double") {
+            tag = TYPE_DOUBLE;
+        } else if (base_type == "string") {
+            tag = TYPE_STRING;
+        } else if (base_type == "image") {
+            tag = TYPE_IMAGE;
+        } else if (base_type == "ipfs") {
+            tag = TYPE_IPFS;
+        } else if (base_type == "bool") {
+            tag = TYPE_BOOL;
+        } else if (base_type == "byte") {
+            tag = TYPE_BYTE;
+        } else {
+            check(false, "No type could be matched - " + type);
+        }
 
+        return {tag, is_array};
+    }
+
+
+    //A schema format with every type string already parsed into its type tag
+    //Build it once per schema and pass it to serialize / deserialize / find_attribute
+    struct compiled_format {
+        vector <COMPILED_LINE> lines;
+
+        compiled_format(const vector <FORMAT> &format_lines) {
+            lines.reserve(format_lines.size());
+            for (const FORMAT &line : format_lines) {
+                COMPILED_TYPE compiled = compile_type(line.type);
+                lines.push_back({line.name, compiled.type, compiled.is_array});
+            }
+        }
+
+        //Returns lines.size() if there is no attribute with this name
+        uint64_t index_of(const string &attribute_name) const {
+            uint64_t index = 0;
+            while (index < lines.size() && lines[index].name != attribute_name) {
+                index++;
+            }
+            return index;
+        }
+    };
+
+
+    inline uint64_t varint_size(uint64_t number) {
+        uint64_t size = 1;
+        while (number >= 128) {
+            number >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+
+    //IPFS hashes decoded by the size pass, in the order the write pass meets them again
+    //Decoding is the most expensive step of serialize, so it is done once per hash
+    struct decoded_ipfs {
+        vector <vector <uint8_t>> hashes;
+        uint64_t                  next = 0;
+    };
+
+
+    //Writes encoded data straight into a buffer that was sized up front, e.g. with serialized_size
+    struct byte_writer {
+        uint8_t      *pos;
+        decoded_ipfs *ipfs;
+
+        void write_varint(uint64_t number) {
+            while (number >= 128) {
+                // sets msb, stores remainder in lower bits
+                *pos++ = (uint8_t)(128 + number % 128);
+                number /= 128;
             }
+            *pos++ = (uint8_t) number;
+        }
+
+        //Little endian, like toIntBytes
+        void write_int(uint64_t number, uint64_t byte_amount) {
+            for (uint64_t i = 0; i < byte_amount; i++) {
+                *pos++ = (uint8_t) number;
+                number >>= 8;
+            }
+        }
+
+        //data() of an empty vector may be null, which memcpy does not accept even for 0 bytes
+        void write_bytes(const void *data, uint64_t length) {
+            if (length == 0) {
+                return;
+            }
+            memcpy(pos, data, length);
+            pos += length;
+        }
+    };
+
+
+    inline string type_name(ATTRIBUTE_TYPE type) {
+        static const char *names[] = {
+            "int8", "int16", "int32", "int64",
+            "uint8", "uint16", "uint32", "uint64",
+            "fixed8", "fixed16", "fixed32", "fixed64",
+            "float", "double",
+            "string", "image", "ipfs",
+            "bool", "byte"
+        };
+        return names[type];
+    }
+
+    //Whether values of the C++ type T are the representation of the attribute type
+    template <typename T>
+    bool holds_type(ATTRIBUTE_TYPE type) {
+        switch (type) {
+        case TYPE_INT8:
+            return std::is_same <T, int8_t>::value;
+        case TYPE_INT16:
+            return std::is_same <T, int16_t>::value;
+        case TYPE_INT32:
+            return std::is_same <T, int32_t>::value;
+        case TYPE_INT64:
+            return std::is_same <T, int64_t>::value;
+        case TYPE_UINT8:
+        case TYPE_FIXED8:
+        case TYPE_BOOL:
+        case TYPE_BYTE:
+            return std::is_same <T, uint8_t>::value;
+        case TYPE_UINT16:
+        case TYPE_FIXED16:
+            return std::is_same <T, uint16_t>::value;
+        case TYPE_UINT32:
+        case TYPE_FIXED32:
+            return std::is_same <T, uint32_t>::value;
+        case TYPE_UINT64:
+        case TYPE_FIXED64:
+            return std::is_same <T, uint64_t>::value;
+        case TYPE_FLOAT:
+            return std::is_same <T, float>::value;
+        case TYPE_DOUBLE:
+            return std::is_same <T, double>::value;
+        case TYPE_STRING:
+        case TYPE_IMAGE:
+        case TYPE_IPFS:
+            return std::is_same <T, string>::value;
         }
+        return false;
+    }
+
+    template <typename T>
+    struct is_vector : std::false_type {};
+
+    template <typename T>
+    struct is_vector <std::vector <T>> : std::true_type {};
+
+
+    //Checks that the value matches the type and returns the size of its encoding
+    template <typename T>
+    uint64_t value_size(ATTRIBUTE_TYPE type, const T &value, decoded_ipfs &ipfs) {
+        check(holds_type <T>(type), "Expected a " + type_name(type) + ", but got something else");
 
-        if (type == "int8") {
-            check(std::holds_alternative <int8_t>(attr), "Expected a int8, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int8_t>(attr)), 1);
-        } else if (type == "int16") {
-            check(std::holds_alternative <int16_t>(attr), "Expected a int16, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int16_t>(attr)), 2);
-        } else if (type == "int32") {
-            check(std::holds_alternative <int32_t>(attr), "Expected a int32, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int32_t>(attr)), 4);
-        } else if (type == "int64") {
-            check(std::holds_alternative <int64_t>(attr), "Expected a int64, but got something else");
-            return toVarintBytes(zigzagEncode(std::get <int64_t>(attr)), 8);
-
-        } else if (type == "uint8") {
-            check(std::holds_alternative <uint8_t>(attr), "Expected a uint8, but got something else");
-            return toVarintBytes(std::get <uint8_t>(attr), 1);
-        } else if (type == "uint16") {
-            check(std::holds_alternative <uint16_t>(attr), "Expected a uint16, but got something else");
-            return toVarintBytes(std::get <uint16_t>(attr), 2);
-        } else if (type == "uint32") {
-            check(std::holds_alternative <uint32_t>(attr), "Expected a uint32, but got something else");
-            return toVarintBytes(std::get <uint32_t>(attr), 4);
-        } else if (type == "uint64") {
-            check(std::holds_alternative <uint64_t>(attr), "Expected a uint64, but got something else");
-            return toVarintBytes(std::get <uint64_t>(attr), 8);
-
-        } else if (type == "fixed8" || type == "byte") {
-            check(std::holds_alternative <uint8_t>(attr), "Expected a uint8 (fixed8 / byte), but got something else");
-            return toIntBytes(std::get <uint8_t>(attr), 1);
-        } else if (type == "fixed16") {
-            check(std::holds_alternative <uint16_t>(attr), "Expected a uint16 (fixed16), but got something else");
-            return toIntBytes(std::get <uint16_t>(attr), 2);
-        } else if (type == "fixed32") {
-            check(std::holds_alternative <uint32_t>(attr), "Expected a uint32 (fixed32), but got something else");
-            return toIntBytes(std::get <uint32_t>(attr), 4);
-        } else if (type == "fixed64") {
-            check(std::holds_alternative <uint64_t>(attr), "Expected a uint64 (fixed64), but got something else");
-            return toIntBytes(std::get <uint64_t>(attr), 8);
-
-        } else if (type == "float") {
-            check(std::holds_alternative <float>(attr), "Expected a float, but got something else");
-            float float_value = std::get <float>(attr);
-            auto *byte_value = reinterpret_cast<uint8_t *>(&float_value);
-            vector <uint8_t> serialized_data = {};
-            serialized_data.reserve(4);
-            for (int i = 0; i < 4; i++) {
-                serialized_data.push_back(*(byte_value + i));
+        if constexpr (std::is_same <T, string>::value) {
+            if (type == TYPE_IPFS) {
+                vector <uint8_t> &result = ipfs.hashes.emplace_back();
+                check(DecodeBase58(value, result), "Error when decoding IPFS string");
+                return varint_size(result.size()) + result.size();
             }
-            return serialized_data;
-
-        } else if (type == "double") {
-            check(std::holds_alternative <double>(attr), "Expected a double, but got something else");
-            double float_value = std::get <double>(attr);
-            auto *byte_value = reinterpret_cast<uint8_t *>(&float_value);
-            vector <uint8_t> serialized_data = {};
-            serialized_data.reserve(8);
-            for (int i = 0; i < 8; i++) {
-                serialized_data.push_back(*(byte_value + i));
+            return varint_size(value.length()) + value.length();
+
+        } else if constexpr (std::is_floating_point <T>::value) {
+            return sizeof(T);
+
+        } else {
+            switch (type) {
+            case TYPE_INT8:
+            case TYPE_INT16:
+            case TYPE_INT32:
+            case TYPE_INT64:
+                return varint_size(zigzagEncode(value));
+            case TYPE_UINT8:
+            case TYPE_UINT16:
+            case TYPE_UINT32:
+            case TYPE_UINT64:
+                return varint_size(value);
+            case TYPE_BOOL:
+                check(value == 0 || value == 1,
+                    "Bools need to be provided as an uin8_t that is either 0 or 1");
+                return 1;
+            default:
+                //fixed and byte
+                return sizeof(T);
+            }
+        }
+    }
+
+    //Writes a value that was already checked by value_size, with the IPFS hashes it decoded
+    template <typename T>
+    void write_value(ATTRIBUTE_TYPE type, const T &value, byte_writer &writer) {
+        if constexpr (std::is_same <T, string>::value) {
+            if (type == TYPE_IPFS) {
+                const vector <uint8_t> &result = writer.ipfs->hashes[writer.ipfs->next++];
+                writer.write_varint(result.size());
+                writer.write_bytes(result.data(), result.size());
+            } else {
+                writer.write_varint(value.length());
+                writer.write_bytes(value.data(), value.length());
             }
-            return serialized_data;
-
-        } else if (type == "string" || type == "image") {
-            check(std::holds_alternative <string>(attr), "Expected a string, but got something else");
-            string text = std::get <string>(attr);
-            vector <uint8_t> serialized_data(text.begin(), text.end());
-
-            vector <uint8_t> length_bytes = toVarintBytes(text.length());
-            serialized_data.insert(serialized_data.begin(), length_bytes.begin(), length_bytes.end());
-            return serialized_data;
-
-        } else if (type == "ipfs") {
-            check(std::holds_alternative <string>(attr), "Expected a string (ipfs), but got something else");
-            vector <uint8_t> result = {};
-            check(DecodeBase58(std::get <string>(attr), result),
-                "Error when decoding IPFS string");
-            vector <uint8_t> length_bytes = toVarintBytes(result.size());
-            result.insert(result.begin(), length_bytes.begin(), length_bytes.end());
-            return result;
-
-        } else if (type == "bool") {
-            check(std::holds_alternative <uint8_t>(attr),
-                "Expected a bool (needs to be provided as uint8_t because of C++ restrictions), but got something else");
-            uint8_t value = std::get <uint8_t>(attr);
-            check(value == 0 || value == 1,
-                "Bools need to be provided as an uin8_t that is either 0 or 1");
-            return {value};
+
+        } else if constexpr (std::is_floating_point <T>::value) {
+            writer.write_bytes(&value, sizeof(T));
 
         } else {
-            check(false, "No type could be matched - " + type);
-            return {}; //This point can never be reached because the check above will always throw.
-            //Just to silence the compiler warning
+            switch (type) {
+            case TYPE_INT8:
+            case TYPE_INT16:
+            case TYPE_INT32:
+            case TYPE_INT64:
+                writer.write_varint(zigzagEncode(value));
+                break;
+            case TYPE_UINT8:
+            case TYPE_UINT16:
+            case TYPE_UINT32:
+            case TYPE_UINT64:
+                writer.write_varint(value);
+                break;
+            default:
+                //fixed, bool and byte
+                writer.write_int(value, sizeof(T));
+                break;
+            }
         }
     }
 
 
-    ATOMIC_ATTRIBUTE deserialize_attribute(const string &type, vector <const uint8_t>::iterator &itr) {
-        if (type.find("[]", type.length() - 2) == type.length() - 2) {
-            //Type is an array
-            uint64_t array_length = unsignedFromVarintBytes(itr);
-            string base_type = type.substr(0, type.length() - 2);
 
-            if (type == "int8[]") {
-                INT8_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int8_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "int16[]") {
-                INT16_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int16_t>(deserialize_attribute(base_type, itr)));
+    //Size of the types that are stored as their raw little endian bytes, 0 for all other types
+    //WASM is little endian, so arrays of these types are copied in and out with a single memcpy
+    inline uint64_t fixed_width(ATTRIBUTE_TYPE type) {
+        switch (type) {
+        case TYPE_FIXED8:
+        case TYPE_BOOL:
+        case TYPE_BYTE:
+            return 1;
+        case TYPE_FIXED16:
+            return 2;
+        case TYPE_FIXED32:
+        case TYPE_FLOAT:
+            return 4;
+        case TYPE_FIXED64:
+        case TYPE_DOUBLE:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    //Array counterpart of value_size: the type is checked once instead of per element
+    //Empty arrays of any element type are accepted, as they were when every element was checked
+    template <typename T>
+    uint64_t array_size(ATTRIBUTE_TYPE type, const vector <T> &values, decoded_ipfs &ipfs) {
+        check(values.empty() || holds_type <T>(type), "Expected a " + type_name(type) + ", but got something else");
+
+        uint64_t size = varint_size(values.size());
+        if constexpr (std::is_same <T, string>::value) {
+            for (const string &value : values) {
+                size += value_size(type, value, ipfs);
+            }
+
+        } else if constexpr (std::is_floating_point <T>::value) {
+            size += values.size() * sizeof(T);
+
+        } else {
+            switch (type) {
+            case TYPE_INT8:
+            case TYPE_INT16:
+            case TYPE_INT32:
+            case TYPE_INT64:
+                for (T value : values) {
+                    size += varint_size(zigzagEncode(value));
                 }
-                return vec;
-            } else if (type == "int32[]") {
-                INT32_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int32_t>(deserialize_attribute(base_type, itr)));
+                break;
+            case TYPE_UINT8:
+            case TYPE_UINT16:
+            case TYPE_UINT32:
+            case TYPE_UINT64:
+                for (T value : values) {
+                    size += varint_size(value);
                 }
-                return vec;
-            } else if (type == "int64[]") {
-                INT64_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <int64_t>(deserialize_attribute(base_type, itr)));
+                break;
+            case TYPE_BOOL:
+                for (T value : values) {
+                    check(value == 0 || value == 1,
+                        "Bools need to be provided as an uin8_t that is either 0 or 1");
                 }
-                return vec;
+                size += values.size();
+                break;
+            default:
+                //fixed and byte
+                size += values.size() * sizeof(T);
+                break;
+            }
+        }
+        return size;
+    }
 
-            } else if (type == "uint8[]" || type == "fixed8[]" || type == "bool[]") {
-                UINT8_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint8_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "uint16[]" || type == "fixed16[]") {
-                UINT16_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint16_t>(deserialize_attribute(base_type, itr)));
-                }
-                return vec;
-            } else if (type == "uint32[]" || type == "fixed32[]") {
-                UINT32_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint32_t>(deserialize_attribute(base_type, itr)));
+    //Array counterpart of write_value, for arrays that were already checked by array_size
+    template <typename T>
+    void write_array(ATTRIBUTE_TYPE type, const vector <T> &values, byte_writer &writer) {
+        writer.write_varint(values.size());
+
+        if constexpr (std::is_same <T, string>::value) {
+            for (const string &value : values) {
+                write_value(type, value, writer);
+            }
+
+        } else {
+            if (fixed_width(type) != 0) {
+                writer.write_bytes(values.data(), values.size() * sizeof(T));
+                return;
+            }
+
+            if constexpr (std::is_signed <T>::value) {
+                for (T value : values) {
+                    writer.write_varint(zigzagEncode(value));
                 }
-                return vec;
-            } else if (type == "uint64[]" || type == "fixed64[]") {
-                UINT64_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <uint64_t>(deserialize_attribute(base_type, itr)));
+            } else {
+                for (T value : values) {
+                    writer.write_varint(value);
                 }
-                return vec;
+            }
+        }
+    }
 
-            } else if (type == "float[]") {
-                FLOAT_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <float>(deserialize_attribute(base_type, itr)));
+
+    //Checks that the attribute matches the type and returns the size of its encoding
+    inline uint64_t attribute_size(ATTRIBUTE_TYPE type, bool is_array, const ATOMIC_ATTRIBUTE &attr, decoded_ipfs &ipfs) {
+        return std::visit([&](const auto &value) -> uint64_t {
+            typedef std::decay_t <decltype(value)> V;
+
+            if constexpr (is_vector <V>::value) {
+                check(is_array, "Expected a " + type_name(type) + ", but got an array");
+                return array_size(type, value, ipfs);
+            } else {
+                check(!is_array, "Expected a " + type_name(type) + "[], but got something else");
+                return value_size(type, value, ipfs);
+            }
+        }, attr);
+    }
+
+    inline void write_attribute(ATTRIBUTE_TYPE type, bool is_array, const ATOMIC_ATTRIBUTE &attr, byte_writer &writer) {
+        std::visit([&](const auto &value) {
+            typedef std::decay_t <decltype(value)> V;
+
+            if constexpr (is_vector <V>::value) {
+                write_array(type, value, writer);
+            } else {
+                write_value(type, value, writer);
+            }
+        }, attr);
+    }
+
+    inline vector <uint8_t> serialize_attribute(ATTRIBUTE_TYPE type, bool is_array, const ATOMIC_ATTRIBUTE &attr) {
+        decoded_ipfs ipfs;
+        vector <uint8_t> serialized_data(attribute_size(type, is_array, attr, ipfs));
+        byte_writer writer = {serialized_data.data(), &ipfs};
+        write_attribute(type, is_array, attr, writer);
+        return serialized_data;
+    }
+
+    inline vector <uint8_t> serialize_attribute(const string &type, const ATOMIC_ATTRIBUTE &attr) {
+        COMPILED_TYPE compiled = compile_type(type);
+        return serialize_attribute(compiled.type, compiled.is_array, attr);
+    }
+
+
+    //Bounded reader over a serialized blob
+    //Every read checks the end of the data first, so malformed blobs fail instead of reading past it
+    struct byte_reader {
+        const uint8_t *pos;
+        const uint8_t *end;
+
+        byte_reader(const uint8_t *data, size_t size) : pos(data), end(data + size) {}
+
+        bool empty() const {
+            return pos == end;
+        }
+
+        size_t remaining() const {
+            return end - pos;
+        }
+
+        uint8_t read_byte() {
+            check(pos != end, "Unexpected end of serialized data");
+            return *pos++;
+        }
+
+        uint64_t read_varint() {
+            uint64_t number = 0;
+            uint64_t shift = 0;
+            uint8_t next_byte;
+
+            do {
+                check(shift < 64, "Varint is too long");
+                next_byte = read_byte();
+                number |= ((uint64_t)(next_byte & 127)) << shift;
+                shift += 7;
+            } while (next_byte >= 128);
+
+            return number;
+        }
+
+        //Little endian, like unsignedFromIntBytes
+        uint64_t read_int(uint64_t byte_amount) {
+            const uint8_t *bytes = read_bytes(byte_amount);
+            uint64_t number = 0;
+            for (uint64_t i = byte_amount; i > 0; i--) {
+                number = (number << 8) | bytes[i - 1];
+            }
+            return number;
+        }
+
+        //Returns a pointer to the next length bytes inside the blob
+        const uint8_t *read_bytes(uint64_t length) {
+            check(length <= remaining(), "Unexpected end of serialized data");
+            const uint8_t *bytes = pos;
+            pos += length;
+            return bytes;
+        }
+
+        //Array lengths are checked against the remaining data, as every element takes at least one byte
+        uint64_t read_length() {
+            uint64_t length = read_varint();
+            check(length <= remaining(), "Unexpected end of serialized data");
+            return length;
+        }
+
+        std::string_view read_string() {
+            uint64_t length = read_length();
+            return std::string_view((const char *) read_bytes(length), length);
+        }
+    };
+
+
+    //Decodes the varint at itr through a byte_reader, so it cannot read past end
+    inline uint64_t unsignedFromVarintBytes(vector <uint8_t>::const_iterator &itr, vector <uint8_t>::const_iterator end) {
+        check(itr != end, "Unexpected end of serialized data");
+        byte_reader reader(&*itr, end - itr);
+        uint64_t number = reader.read_varint();
+        itr += reader.pos - &*itr;
+        return number;
+    }
+
+
+    //Non-owning (pointer, size) view of raw bytes inside a blob
+    struct byte_span {
+        const uint8_t *data;
+        size_t         size;
+    };
+
+
+    inline ATOMIC_ATTRIBUTE deserialize_attribute(ATTRIBUTE_TYPE type, bool is_array, byte_reader &reader);
+
+    //Decodes an array straight into its vector, reserving once from the length prefix
+    template <typename T>
+    ATOMIC_ATTRIBUTE deserialize_array(ATTRIBUTE_TYPE base_type, byte_reader &reader) {
+        uint64_t array_length = reader.read_length();
+        vector <T> vec;
+
+        if constexpr (std::is_same <T, string>::value) {
+            vec.reserve(array_length);
+            for (uint64_t i = 0; i < array_length; i++) {
+                if (base_type == TYPE_IPFS) {
+                    uint64_t hash_length = reader.read_length();
+                    const uint8_t *hash = reader.read_bytes(hash_length);
+                    vec.push_back(EncodeBase58(hash, hash + hash_length));
+                } else {
+                    vec.emplace_back(reader.read_string());
                 }
-                return vec;
+            }
 
-            } else if (type == "double[]") {
-                DOUBLE_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <double>(deserialize_attribute(base_type, itr)));
+        } else {
+            if (fixed_width(base_type) != 0) {
+                if (array_length > 0) {
+                    const uint8_t *bytes = reader.read_bytes(array_length * sizeof(T));
+                    vec.resize(array_length);
+                    memcpy(vec.data(), bytes, array_length * sizeof(T));
                 }
                 return vec;
+            }
 
-            } else if (type == "string[]" || type == "image[]") {
-                STRING_VEC vec = {};
-                for (uint64_t i = 0; i < array_length; i++) {
-                    vec.push_back(std::get <string>(deserialize_attribute(base_type, itr)));
+            vec.reserve(array_length);
+            for (uint64_t i = 0; i < array_length; i++) {
+                if constexpr (std::is_signed <T>::value) {
+                    vec.push_back((T) zigzagDecode(reader.read_varint()));
+                } else {
+                    vec.push_back((T) reader.read_varint());
                 }
-                return vec;
+            }
+        }
+        return vec;
+    }
 
+    inline ATOMIC_ATTRIBUTE deserialize_attribute(ATTRIBUTE_TYPE type, bool is_array, byte_reader &reader) {
+        if (is_array) {
+            switch (type) {
+            case TYPE_INT8:
+                return deserialize_array <int8_t>(type, reader);
+            case TYPE_INT16:
+                return deserialize_array <int16_t>(type, reader);
+            case TYPE_INT32:
+                return deserialize_array <int32_t>(type, reader);
+            case TYPE_INT64:
+                return deserialize_array <int64_t>(type, reader);
+            case TYPE_UINT8:
+            case TYPE_FIXED8:
+            case TYPE_BOOL:
+            case TYPE_BYTE:
+                return deserialize_array <uint8_t>(type, reader);
+            case TYPE_UINT16:
+            case TYPE_FIXED16:
+                return deserialize_array <uint16_t>(type, reader);
+            case TYPE_UINT32:
+            case TYPE_FIXED32:
+                return deserialize_array <uint32_t>(type, reader);
+            case TYPE_UINT64:
+            case TYPE_FIXED64:
+                return deserialize_array <uint64_t>(type, reader);
+            case TYPE_FLOAT:
+                return deserialize_array <float>(type, reader);
+            case TYPE_DOUBLE:
+                return deserialize_array <double>(type, reader);
+            case TYPE_STRING:
+            case TYPE_IMAGE:
+            case TYPE_IPFS:
+                return deserialize_array <string>(type, reader);
             }
         }
 
-        if (type == "int8") {
-            return (int8_t) zigzagDecode(unsignedFromVarintBytes(itr));
-        } else if (type == "int16") {
-            return (int16_t) zigzagDecode(unsignedFromVarintBytes(itr));
-        } else if (type == "int32") {
-            return (int32_t) zigzagDecode(unsignedFromVarintBytes(itr));
-        } else if (type == "int64") {
-            return (int64_t) zigzagDecode(unsignedFromVarintBytes(itr));
-
-        } else if (type == "uint8") {
-            return (uint8_t) unsignedFromVarintBytes(itr);
-        } else if (type == "uint16") {
-            return (uint16_t) unsignedFromVarintBytes(itr);
-        } else if (type == "uint32") {
-            return (uint32_t) unsignedFromVarintBytes(itr);
-        } else if (type == "uint64") {
-            return (uint64_t) unsignedFromVarintBytes(itr);
-
-        } else if (type == "fixed8") {
-            return (uint8_t) unsignedFromIntBytes(itr, 1);
-        } else if (type == "fixed16") {
-            return (uint16_t) unsignedFromIntBytes(itr, 2);
-        } else if (type == "fixed32") {
-            return (uint32_t) unsignedFromIntBytes(itr, 4);
-        } else if (type == "fixed64") {
-            return (uint64_t) unsignedFromIntBytes(itr, 8);
-
-        } else if (type == "float") {
-            uint8_t array_repr[4];
-            for (uint8_t &i : array_repr) {
-                i = *itr;
-                itr++;
+        switch (type) {
+        case TYPE_INT8:
+            return (int8_t) zigzagDecode(reader.read_varint());
+        case TYPE_INT16:
+            return (int16_t) zigzagDecode(reader.read_varint());
+        case TYPE_INT32:
+            return (int32_t) zigzagDecode(reader.read_varint());
+        case TYPE_INT64:
+            return (int64_t) zigzagDecode(reader.read_varint());
+
+        case TYPE_UINT8:
+            return (uint8_t) reader.read_varint();
+        case TYPE_UINT16:
+            return (uint16_t) reader.read_varint();
+        case TYPE_UINT32:
+            return (uint32_t) reader.read_varint();
+        case TYPE_UINT64:
+            return (uint64_t) reader.read_varint();
+
+        case TYPE_FIXED8:
+            return (uint8_t) reader.read_int(1);
+        case TYPE_FIXED16:
+            return (uint16_t) reader.read_int(2);
+        case TYPE_FIXED32:
+            return (uint32_t) reader.read_int(4);
+        case TYPE_FIXED64:
+            return (uint64_t) reader.read_int(8);
+
+        case TYPE_FLOAT: {
+            float value;
+            memcpy(&value, reader.read_bytes(sizeof(value)), sizeof(value));
+            return value;
+        }
+        case TYPE_DOUBLE: {
+            double value;
+            memcpy(&value, reader.read_bytes(sizeof(value)), sizeof(value));
+            return value;
+        }
+
+        case TYPE_STRING:
+        case TYPE_IMAGE:
+            return string(reader.read_string());
+
+        case TYPE_IPFS: {
+            uint64_t array_length = reader.read_length();
+            const uint8_t *bytes = reader.read_bytes(array_length);
+            return EncodeBase58(bytes, bytes + array_length);
+        }
+
+        case TYPE_BOOL:
+        case TYPE_BYTE:
+            return reader.read_byte();
+        }
+
+        check(false, "No type could be matched");
+        return ""; //This point can never be reached because the check above will always throw.
+        //Just to silence the compiler warning
+    }
+
+    inline ATOMIC_ATTRIBUTE deserialize_attribute(const string &type, byte_reader &reader) {
+        COMPILED_TYPE compiled = compile_type(type);
+        return deserialize_attribute(compiled.type, compiled.is_array, reader);
+    }
+
+
+    //Moves the reader past one attribute without decoding it
+    //Strings, ipfs hashes and arrays are jumped over using their varint length prefix
+    inline void skip_attribute(ATTRIBUTE_TYPE type, bool is_array, byte_reader &reader) {
+        if (is_array) {
+            uint64_t array_length = reader.read_length();
+            if (fixed_width(type) != 0) {
+                reader.read_bytes(array_length * fixed_width(type));
+                return;
             }
-            auto *val = reinterpret_cast<float *>(&array_repr);
-            return *val;
-
-        } else if (type == "double") {
-            uint8_t array_repr[8];
-            for (uint8_t &i : array_repr) {
-                i = *itr;
-                itr++;
+            for (uint64_t i = 0; i < array_length; i++) {
+                skip_attribute(type, false, reader);
             }
-            auto *val = reinterpret_cast<double *>(&array_repr);
-            return *val;
+            return;
+        }
 
-        } else if (type == "string" || type == "image") {
-            uint64_t string_length = unsignedFromVarintBytes(itr);
-            string text(itr, itr + string_length);
+        switch (type) {
+        case TYPE_INT8:
+        case TYPE_INT16:
+        case TYPE_INT32:
+        case TYPE_INT64:
+        case TYPE_UINT8:
+        case TYPE_UINT16:
+        case TYPE_UINT32:
+        case TYPE_UINT64:
+            reader.read_varint();
+            break;
+
+        case TYPE_FIXED8:
+        case TYPE_BOOL:
+        case TYPE_BYTE:
+            reader.read_bytes(1);
+            break;
+        case TYPE_FIXED16:
+            reader.read_bytes(2);
+            break;
+        case TYPE_FIXED32:
+        case TYPE_FLOAT:
+            reader.read_bytes(4);
+            break;
+        case TYPE_FIXED64:
+        case TYPE_DOUBLE:
+            reader.read_bytes(8);
+            break;
+
+        case TYPE_STRING:
+        case TYPE_IMAGE:
+        case TYPE_IPFS:
+            reader.read_bytes(reader.read_length());
+            break;
+        }
+    }
 
-            itr += string_length;
-            return text;
 
-        } else if (type == "ipfs") {
-            uint64_t array_length = unsignedFromVarintBytes(itr);
-            vector <uint8_t> byte_array = {};
-            byte_array.insert(byte_array.begin(), itr, itr + array_length);
+    //Non-owning view of one encoded attribute inside a blob
+    //Nothing is allocated until to_attribute() is called
+    struct attribute_view {
+        ATTRIBUTE_TYPE type;
+        bool           is_array;
+        const uint8_t *data;
+        size_t         size;
 
-            itr += array_length;
-            return EncodeBase58(byte_array);
+        byte_reader reader() const {
+            return byte_reader(data, size);
+        }
 
-        } else if (type == "bool" || type == "byte") {
-            uint8_t next_byte = *itr;
-            itr++;
-            return next_byte;
+        //string and image attributes
+        std::string_view as_string_view() const {
+            check(!is_array && (type == TYPE_STRING || type == TYPE_IMAGE), "Attribute is not a string");
+            byte_reader attribute_reader = reader();
+            return attribute_reader.read_string();
+        }
 
-        } else {
-            check(false, "No type could be matched - " + type);
-            return ""; //This point can never be reached because the check above will always throw.
-            //Just to silence the compiler warning
+        //Raw bytes of ipfs hashes, and of bool / byte / fixed8 arrays
+        byte_span as_bytes() const {
+            byte_reader attribute_reader = reader();
+            if (!is_array && type == TYPE_IPFS) {
+                uint64_t length = attribute_reader.read_length();
+                return {attribute_reader.read_bytes(length), length};
+            }
+            check(is_array && (type == TYPE_BOOL || type == TYPE_BYTE || type == TYPE_FIXED8),
+                "Attribute is not a byte array");
+            uint64_t length = attribute_reader.read_length();
+            return {attribute_reader.read_bytes(length), length};
+        }
+
+        ATOMIC_ATTRIBUTE to_attribute() const {
+            byte_reader attribute_reader = reader();
+            return deserialize_attribute(type, is_array, attribute_reader);
+        }
+    };
+
+
+    //Locates the attribute with the given name without decoding any attribute
+    inline std::optional <attribute_view> find_attribute_view(
+        const uint8_t *data,
+        size_t size,
+        const compiled_format &format,
+        const string &attribute_name
+    ) {
+        uint64_t wanted = format.index_of(attribute_name);
+        if (wanted == format.lines.size()) {
+            return std::nullopt;
+        }
+
+        byte_reader reader(data, size);
+        while (!reader.empty()) {
+            uint64_t identifier = reader.read_varint();
+            check(identifier >= RESERVED && identifier - RESERVED < format.lines.size(),
+                "Unknown attribute identifier in serialized data");
+
+            const COMPILED_LINE &line = format.lines[identifier - RESERVED];
+            const uint8_t *start = reader.pos;
+            skip_attribute(line.type, line.is_array, reader);
+
+            if (identifier - RESERVED == wanted) {
+                return attribute_view{line.type, line.is_array, start, (size_t)(reader.pos - start)};
+            }
         }
+
+        return std::nullopt;
     }
 
+    //Same lookup on a raw schema format: the names are compared in place and only the types
+    //of the attributes present before the wanted one are compiled, so nothing is built per line
+    inline std::optional <attribute_view> find_attribute_view(
+        const uint8_t *data,
+        size_t size,
+        const vector <FORMAT> &format_lines,
+        const string &attribute_name
+    ) {
+        uint64_t wanted = 0;
+        while (wanted < format_lines.size() && format_lines[wanted].name != attribute_name) {
+            wanted++;
+        }
+        if (wanted == format_lines.size()) {
+            return std::nullopt;
+        }
+
+        byte_reader reader(data, size);
+        while (!reader.empty()) {
+            uint64_t identifier = reader.read_varint();
+            check(identifier >= RESERVED && identifier - RESERVED < format_lines.size(),
+                "Unknown attribute identifier in serialized data");
 
-    vector <uint8_t> serialize(ATTRIBUTE_MAP attr_map, const vector <FORMAT> &format_lines) {
-        uint64_t number = 0;
-        vector <uint8_t> serialized_data = {};
-        for (FORMAT line : format_lines) {
+            COMPILED_TYPE compiled = compile_type(format_lines[identifier - RESERVED].type);
+            const uint8_t *start = reader.pos;
+            skip_attribute(compiled.type, compiled.is_array, reader);
+
+            if (identifier - RESERVED == wanted) {
+                return attribute_view{compiled.type, compiled.is_array, start, (size_t)(reader.pos - start)};
+            }
+        }
+
+        return std::nullopt;
+    }
+
+
+    //Exact size of serialize(attr_map, format), also checks every attribute against its type
+    inline uint64_t serialized_size(const ATTRIBUTE_MAP &attr_map, const compiled_format &format, decoded_ipfs &ipfs) {
+        uint64_t size = 0;
+        uint64_t matched = 0;
+        for (uint64_t number = 0; number < format.lines.size(); number++) {
+            const COMPILED_LINE &line = format.lines[number];
             auto attribute_itr = attr_map.find(line.name);
             if (attribute_itr != attr_map.end()) {
-                const vector <uint8_t> &identifier = toVarintBytes(number + RESERVED);
-                serialized_data.insert(serialized_data.end(), identifier.begin(), identifier.end());
+                size += varint_size(number + RESERVED);
+                size += attribute_size(line.type, line.is_array, attribute_itr->second, ipfs);
+                matched++;
+            }
+        }
+        if (matched != attr_map.size()) {
+            for (const auto &attribute : attr_map) {
+                check(format.index_of(attribute.first) != format.lines.size(),
+                    "The following attribute could not be serialized, because it is not specified in the provided format: "
+                    + attribute.first);
+            }
+        }
+        return size;
+    }
 
-                const vector <uint8_t> &child_data = serialize_attribute(line.type, attribute_itr->second);
-                serialized_data.insert(serialized_data.end(), child_data.begin(), child_data.end());
+    inline uint64_t serialized_size(const ATTRIBUTE_MAP &attr_map, const compiled_format &format) {
+        decoded_ipfs ipfs;
+        return serialized_size(attr_map, format, ipfs);
+    }
+
+    //Encodes into one buffer of the exact size, computed by a first pass over the attributes
+    inline vector <uint8_t> serialize(const ATTRIBUTE_MAP &attr_map, const compiled_format &format) {
+        decoded_ipfs ipfs;
+        vector <uint8_t> serialized_data(serialized_size(attr_map, format, ipfs));
+        byte_writer writer = {serialized_data.data(), &ipfs};
 
-                attr_map.erase(attribute_itr);
+        for (uint64_t number = 0; number < format.lines.size(); number++) {
+            const COMPILED_LINE &line = format.lines[number];
+            auto attribute_itr = attr_map.find(line.name);
+            if (attribute_itr != attr_map.end()) {
+                writer.write_varint(number + RESERVED);
+                write_attribute(line.type, line.is_array, attribute_itr->second, writer);
             }
-            number++;
-        }
-        if (attr_map.begin() != attr_map.end()) {
-            check(false,
-                "The following attribute could not be serialized, because it is not specified in the provided format: "
-                + attr_map.begin()->first);
         }
+
         return serialized_data;
     }
 
+    inline vector <uint8_t> serialize(const ATTRIBUTE_MAP &attr_map, const vector <FORMAT> &format_lines) {
+        return serialize(attr_map, compiled_format(format_lines));
+    }
+
 
-    ATTRIBUTE_MAP deserialize(const vector <uint8_t> &data, const vector <FORMAT> &format_lines) {
+    inline ATTRIBUTE_MAP deserialize(const uint8_t *data, size_t size, const compiled_format &format) {
         ATTRIBUTE_MAP attr_map = {};
 
-        auto itr = data.begin();
-        while (itr != data.end()) {
-            uint64_t identifier = unsignedFromVarintBytes(itr);
-            FORMAT format = format_lines.at(identifier - RESERVED);
-            attr_map[format.name] = deserialize_attribute(format.type, itr);
+        byte_reader reader(data, size);
+        while (!reader.empty()) {
+            uint64_t identifier = reader.read_varint();
+            check(identifier >= RESERVED && identifier - RESERVED < format.lines.size(),
+                "Unknown attribute identifier in serialized data");
+
+            const COMPILED_LINE &line = format.lines[identifier - RESERVED];
+            attr_map[line.name] = deserialize_attribute(line.type, line.is_array, reader);
         }
 
         return attr_map;
     }
-}
\ No newline at end of file
+
+    inline ATTRIBUTE_MAP deserialize(const vector <uint8_t> &data, const compiled_format &format) {
+        return deserialize(data.data(), data.size(), format);
+    }
+
+    inline ATTRIBUTE_MAP deserialize(const vector <uint8_t> &data, const vector <FORMAT> &format_lines) {
+        return deserialize(data.data(), data.size(), compiled_format(format_lines));
+    }
+
+
+    //Decodes only the attribute with the given name, skipping over all the others
+    inline std::optional <ATOMIC_ATTRIBUTE> find_attribute(
+        const vector <uint8_t> &data,
+        const compiled_format &format,
+        const string &attribute_name
+    ) {
+        std::optional <attribute_view> view = find_attribute_view(data.data(), data.size(), format, attribute_name);
+        if (!view) {
+            return std::nullopt;
+        }
+        return view->to_attribute();
+    }
+
+    inline std::optional <ATOMIC_ATTRIBUTE> find_attribute(
+        const vector <uint8_t> &data,
+        const vector <FORMAT> &format_lines,
+        const string &attribute_name
+    ) {
+        std::optional <attribute_view> view = find_attribute_view(data.data(), data.size(), format_lines, attribute_name);
+        if (!view) {
+            return std::nullopt;
+        }
+        return view->to_attribute();
+    }
+
+
+    template <typename T, typename FORMAT_TYPE>
+    std::optional <T> get_as(
+        const vector <uint8_t> &data,
+        const FORMAT_TYPE &format,
+        const string &attribute_name
+    ) {
+        std::optional <ATOMIC_ATTRIBUTE> attr = find_attribute(data, format, attribute_name);
+        if (!attr) {
+            return std::nullopt;
+        }
+
+        check(std::holds_alternative <T>(*attr), "Attribute " + attribute_name + " has an unexpected type");
+        return std::get <T>(*attr);
+    }
+}
@@ -4,6 +4,12 @@
 
 //(Slightly modified for the needs of our eosio contract)
 
+#pragma once
+
+#include <cassert>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -29,7 +35,7 @@ static const int8_t mapBase58[256] = {
 };
 
 
-std::string EncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
+inline std::string EncodeBase58Generic(const unsigned char* pbegin, const unsigned char* pend)
 {
     // Skip & count leading zeroes.
     int zeroes = 0;
@@ -69,14 +75,79 @@ std::string EncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
     return str;
 }
 
-std::string EncodeBase58(const std::vector<unsigned char>& vch)
+/**
+ * IPFS CIDv0 hashes are 34 byte sha256 multihashes, which are 46 characters in base58.
+ * These are by far the most common inputs, so they get a codec that works on the stack
+ * and converts between 32 bit limbs and limbs of 5 base58 digits instead of single bytes and digits.
+ */
+static const int IPFS_HASH_BYTES = 34;
+static const int IPFS_HASH_CHARS = 46;
+static const uint64_t BASE58_POW5 = 58ULL * 58 * 58 * 58 * 58; // 656356768, fits in 30 bits
+
+inline std::string EncodeBase58Hash(const unsigned char* pbegin)
+{
+    // Skip & count leading zeroes.
+    int zeroes = 0;
+    while (zeroes < IPFS_HASH_BYTES && pbegin[zeroes] == 0)
+        zeroes++;
+    // 34 bytes are at most 47 base58 digits, which fit in 10 limbs of 5 digits, least significant first.
+    uint32_t limbs[10];
+    int length = 0;
+    // Feed the first 2 bytes, then 8 big-endian 32 bit words: "limbs = limbs * 2^bits + word".
+    for (int pos = 0; pos < IPFS_HASH_BYTES;) {
+        int bits = pos == 0 ? 16 : 32;
+        uint64_t carry = 0;
+        for (int b = 0; b < bits / 8; b++, pos++)
+            carry = (carry << 8) | pbegin[pos];
+        for (int i = 0; i < length; i++) {
+            carry += (uint64_t)limbs[i] << bits;
+            limbs[i] = carry % BASE58_POW5;
+            carry /= BASE58_POW5;
+        }
+        while (carry != 0) {
+            assert(length < 10);
+            limbs[length++] = carry % BASE58_POW5;
+            carry /= BASE58_POW5;
+        }
+    }
+    // Expand the limbs into digits, most significant first.
+    char digits[50];
+    for (int i = 0; i < length; i++) {
+        uint32_t limb = limbs[length - 1 - i];
+        for (int d = 4; d >= 0; d--) {
+            digits[i * 5 + d] = limb % 58;
+            limb /= 58;
+        }
+    }
+    // Skip leading zeroes in base58 result.
+    int first = 0;
+    while (first < length * 5 && digits[first] == 0)
+        first++;
+    // Translate the result into a string.
+    char str[IPFS_HASH_BYTES + 50];
+    int str_length = 0;
+    for (int i = 0; i < zeroes; i++)
+        str[str_length++] = '1';
+    for (int i = first; i < length * 5; i++)
+        str[str_length++] = pszBase58[(uint8_t)digits[i]];
+    return std::string(str, str_length);
+}
+
+inline std::string EncodeBase58(const unsigned char* pbegin, const unsigned char* pend)
+{
+    if (pend - pbegin == IPFS_HASH_BYTES)
+        return EncodeBase58Hash(pbegin);
+    return EncodeBase58Generic(pbegin, pend);
+}
+
+inline std::string EncodeBase58(const std::vector<unsigned char>& vch)
 {
     return EncodeBase58(vch.data(), vch.data() + vch.size());
 }
 
 
 //Removed the max return length.
-bool DecodeBase58(const char* psz, std::vector<unsigned char>& vch)
+inline bool DecodeBase58Generic(const char* psz, std::vector<unsigned char>& vch)
 {
     // Skip leading spaces.
     while (*psz && isspace(*psz))
@@ -123,7 +194,65 @@ bool DecodeBase58(const char* psz, std::vector<unsigned char>& vch)
     return true;
 }
 
-bool DecodeBase58(const std::string& str, std::vector<unsigned char>& vchRet)
+//Expects exactly IPFS_HASH_CHARS characters without surrounding spaces.
+inline bool DecodeBase58Hash(const char* psz, std::vector<unsigned char>& vch)
+{
+    // Skip and count leading '1's.
+    int zeroes = 0;
+    while (zeroes < IPFS_HASH_CHARS && psz[zeroes] == '1')
+        zeroes++;
+    // 58^46 < 2^270, so the value fits in 9 limbs of 32 bits, least significant first.
+    uint32_t limbs[9];
+    int length = 0;
+    // Feed the first character, then 9 groups of 5: "limbs = limbs * 58^digits + group".
+    for (int pos = 0; pos < IPFS_HASH_CHARS;) {
+        int digits = pos == 0 ? 1 : 5;
+        uint64_t multiplier = 1;
+        uint64_t carry = 0;
+        for (int d = 0; d < digits; d++, pos++) {
+            int value = mapBase58[(uint8_t)psz[pos]];
+            if (value == -1)  // Invalid b58 character
+                return false;
+            carry = carry * 58 + value;
+            multiplier *= 58;
+        }
+        for (int i = 0; i < length; i++) {
+            carry += limbs[i] * multiplier;
+            limbs[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        while (carry != 0) {
+            assert(length < 9);
+            limbs[length++] = (uint32_t)carry;
+            carry >>= 32;
+        }
+    }
+    // Expand the limbs into big-endian bytes and skip their leading zeroes.
+    unsigned char b256[36];
+    for (int i = 0; i < length; i++) {
+        uint32_t limb = limbs[length - 1 - i];
+        for (int b = 3; b >= 0; b--) {
+            b256[i * 4 + b] = (unsigned char)limb;
+            limb >>= 8;
+        }
+    }
+    int first = 0;
+    while (first < length * 4 && b256[first] == 0)
+        first++;
+    // Copy result into output vector.
+    vch.assign(zeroes, 0x00);
+    vch.insert(vch.end(), b256 + first, b256 + length * 4);
+    return true;
+}
+
+inline bool DecodeBase58(const char* psz, std::vector<unsigned char>& vch)
+{
+    if (strlen(psz) == IPFS_HASH_CHARS && !isspace(psz[0]) && !isspace(psz[IPFS_HASH_CHARS - 1]))
+        return DecodeBase58Hash(psz, vch);
+    return DecodeBase58Generic(psz, vch);
+}
+
+inline bool DecodeBase58(const std::string& str, std::vector<unsigned char>& vchRet)
 {
     return DecodeBase58(str.c_str(), vchRet);
 }
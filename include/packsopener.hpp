@@ -1,7 +1,11 @@
+#pragma once
+
 #include <eosio/eosio.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/singleton.hpp>
 #include <eosio/crypto.hpp>
 #include <eosio/transaction.hpp>
+#include <algorithm>
 #include <atomicassets.hpp>
 #include <atomicdata.hpp>
 
@@ -18,6 +22,51 @@ CONTRACT packsopener : public contract
 public:
     using contract::contract;
 
+    //template_id -1 means that the roll gives nothing
+    struct OUTCOME {
+        int32_t             template_id;
+        uint32_t            odds;
+    };
+
+    //Rows returned by the read-only queries. resolved: the randomness arrived, assets_ids is
+    //empty for merkle packs until claimproof
+    struct PENDING_UNBOX {
+        uint64_t            pack_asset_id;
+        uint64_t            pack_id;
+        bool                resolved;
+        vector<uint64_t>    assets_ids;
+    };
+
+    struct STAKED_AVATAR {
+        uint64_t            pack_asset_id;
+        string              rarity;
+        bool                claimable;
+    };
+
+    struct INVENTORY_BUNDLE {
+        uint64_t            position;
+        vector<uint64_t>    assets_ids;
+    };
+
+    //A page of a read-only query. When more is set, next_cursor is the cursor of the next page
+    struct PENDING_PAGE {
+        vector<PENDING_UNBOX>       rows;
+        bool                        more;
+        uint64_t                    next_cursor;
+    };
+
+    struct AVATAR_PAGE {
+        vector<STAKED_AVATAR>       rows;
+        bool                        more;
+        uint64_t                    next_cursor;
+    };
+
+    struct INVENTORY_PAGE {
+        vector<INVENTORY_BUNDLE>    rows;
+        bool                        more;
+        uint64_t                    next_cursor;
+    };
+
     ACTION createavatar(
         name unboxer,
         uint64_t pack_asset_id,
@@ -34,6 +83,16 @@ public:
         uint64_t pack_asset_id
     );
 
+    ACTION setavtmpl(
+        int32_t template_id,
+        string rarity,
+        string rarity_attribute
+    );
+
+    ACTION delavtmpl(
+        int32_t template_id
+    );
+
     ACTION createpack(
         name authorized_account,
         name collection_name,
@@ -42,6 +101,41 @@ public:
         string display_data
     );
 
+    ACTION setpackcfg(
+        uint64_t pack_id,
+        bool auto_claim,
+        bool compact
+    );
+
+    ACTION addpackroll(
+        uint64_t pack_id,
+        vector<OUTCOME> outcomes
+    );
+
+    ACTION setpackroot(
+        uint64_t pack_id,
+        checksum256 root,
+        uint64_t leaf_count
+    );
+
+    ACTION setslotpool(
+        uint64_t pack_id,
+        uint64_t first_asset_id,
+        uint64_t slot_count,
+        uint64_t assets_per_slot
+    );
+
+    ACTION commitshuf(
+        uint64_t pack_id,
+        checksum256 commitment,
+        uint64_t window
+    );
+
+    ACTION revealshuf(
+        uint64_t pack_id,
+        checksum256 seed
+    );
+
     ACTION retryrand(
         uint64_t pack_asset_id
     );
@@ -55,19 +149,61 @@ public:
         uint64_t pack_asset_id
     );
 
+    ACTION claimproof(
+        uint64_t pack_asset_id,
+        vector<uint64_t> assets_ids,
+        vector<checksum256> proof
+    );
+
+    ACTION claimall(
+        name unboxer,
+        uint64_t limit
+    );
+
     // TODO: esto hay que hacerlo de otra forma, una vez se tienen todos los assets se crean todos los sobres disponibles
     ACTION addpack(
         uint64_t pack_id,
         vector<uint64_t> assets_ids
     );
 
+    ACTION addpacks(
+        uint64_t pack_id,
+        vector<vector<uint64_t>> bundles
+    );
+
     ACTION genpacks(
         name authorized_account,
-        uint64_t pack_template_id
+        uint64_t pack_template_id,
+        uint64_t max_assets
+    );
+
+    ACTION migratepacks(
+        uint64_t pack_id,
+        uint64_t max_rows
+    );
+
+    [[eosio::action, eosio::read_only]] PENDING_PAGE getpending(
+        name unboxer,
+        uint64_t cursor,
+        uint64_t limit
+    );
+
+    [[eosio::action, eosio::read_only]] AVATAR_PAGE getavatars(
+        name unboxer,
+        uint64_t cursor,
+        uint64_t limit
+    );
+
+    [[eosio::action, eosio::read_only]] INVENTORY_PAGE getinventory(
+        uint64_t pack_id,
+        uint64_t cursor,
+        uint64_t limit
     );
 
     ACTION removeall(
-        string table
+        string table,
+        uint64_t scope,
+        uint64_t max_rows
     );
 
     ACTION lognewpack(
@@ -76,6 +212,19 @@ public:
         uint32_t unlock_time
     );
 
+    ACTION logremove(
+        string table,
+        uint64_t scope,
+        uint64_t removed,
+        bool done
+    );
+
+    ACTION logmigrate(
+        uint64_t pack_id,
+        uint64_t migrated,
+        bool done
+    );
+
     ACTION loggetrand(
         uint64_t assoc_id,
         uint64_t max_value,
@@ -83,10 +232,25 @@ public:
         vector<uint64_t> vec
     );
 
+    ACTION logrolls(
+        uint64_t pack_asset_id,
+        name unboxer,
+        vector<int32_t> template_ids
+    );
+
+    ACTION logaddpacks(
+        uint64_t pack_id,
+        uint64_t added,
+        uint64_t available
+    );
+
     ACTION loggenpacks(
         name authorized_account,
         uint64_t pack_template_id,
-        vector<uint64_t> vec
+        uint64_t scanned,
+        uint64_t added,
+        uint64_t last_asset_id,
+        bool done
     );
 
    [[eosio::on_notify("atomicassets::transfer")]] void receive_asset_transfer(
@@ -113,6 +277,18 @@ private:
         indexed_by < name("templateid"), const_mem_fun < packs_s, uint64_t, &packs_s::by_template_id>>>
     packs_t;
 
+    //auto_claim: receiverand transfers the unboxed assets right away instead of waiting for claimunboxed
+    //compact: new bundles of the pack are stored in compactpacks instead of availpacks
+    TABLE packconfigs_s {
+        uint64_t            pack_id;
+        bool                auto_claim;
+        bool                compact;
+
+        uint64_t primary_key() const { return pack_id; }
+    };
+
+    typedef multi_index<name("packconfigs"), packconfigs_s> packconfigs_t;
+
     TABLE unboxpacks_s {
         uint64_t            pack_asset_id;
         uint64_t            pack_id;
@@ -127,6 +303,16 @@ private:
         indexed_by < name("unboxer"), const_mem_fun < unboxpacks_s, uint64_t, &unboxpacks_s::by_unboxer>>>
     unboxpacks_t;
 
+    //Packs unboxed by the same transfer share one randomness request, keyed by the first pack asset id
+    TABLE unboxbatch_s {
+        uint64_t            assoc_id;
+        vector<uint64_t>    pack_asset_ids;
+
+        uint64_t primary_key() const { return assoc_id; }
+    };
+
+    typedef multi_index<name("unboxbatch"), unboxbatch_s> unboxbatch_t;
+
     TABLE avatarpacks_s {
         uint64_t            pack_asset_id;
         name                unboxer;
@@ -141,6 +327,20 @@ private:
         indexed_by < name("unboxer"), const_mem_fun < avatarpacks_s, uint64_t, &avatarpacks_s::by_unboxer>>>
     avatarpacks_t;
 
+    //Templates of the avatar schema that can be staked with "unbox avatar"
+    //rarity_attribute: when set, the rarity is read from this immutable template attribute instead
+    TABLE avatartmpls_s {
+        int32_t             template_id;
+        string              rarity;
+        string              rarity_attribute;
+
+        uint64_t primary_key() const { return (uint64_t) template_id; }
+    };
+
+    typedef multi_index<name("avatartmpls"), avatartmpls_s> avatartmpls_t;
+
+    //id: pack_id in the high 32 bits, position inside the pack inventory in the low 32 bits
+    //Positions of a pack are always dense in [0, availcounts.count)
     TABLE availpacks_s {
         uint64_t            id;
         uint64_t            pack_id;
@@ -154,17 +354,256 @@ private:
         indexed_by < name("packid"), const_mem_fun < availpacks_s, uint64_t, &availpacks_s::by_pack_id>>>
     availpacks_t;
 
+    //Same ids and positions as availpacks, a position is stored in one of the two tables
+    //data: the first asset id followed by the zigzag deltas to the previous asset id, all as varints
+    TABLE compactpacks_s {
+        uint64_t            id;
+        vector<uint8_t>     data;
+
+        uint64_t primary_key() const { return id; }
+    };
+
+    typedef multi_index<name("compactpacks"), compactpacks_s> compactpacks_t;
+
+    //Reverse index of the bundled assets, so an asset is bundled at most once. An asset is indexed from the load
+    //of its bundle until it leaves the contract with a claim, so unboxed but unclaimed assets stay indexed
+    //Rows are disjoint ranges of consecutive asset ids, so assets minted in a batch and bundled together
+    //take one row between them instead of one row each. Ranges do not depend on packs or positions
+    TABLE assetranges_s {
+        uint64_t            first_asset_id;
+        uint64_t            last_asset_id;
+
+        uint64_t primary_key() const { return first_asset_id; }
+    };
+
+    typedef multi_index<name("assetranges"), assetranges_s> assetranges_t;
+
+    //Pre-shuffled packs: bundles are shuffled with the seed as they are loaded and unboxes pick
+    //among the last window positions. commitment is the sha256 of the seed, which is revealed before loading
+    TABLE shuffles_s {
+        uint64_t            pack_id;
+        checksum256         commitment;
+        checksum256         seed;
+        bool                revealed;
+        uint64_t            window;
+
+        uint64_t primary_key() const { return pack_id; }
+    };
+
+    typedef multi_index<name("shuffles"), shuffles_s> shuffles_t;
+
+    TABLE availcounts_s {
+        uint64_t            pack_id;
+        uint64_t            count;
+
+        uint64_t primary_key() const { return pack_id; }
+    };
+
+    typedef multi_index<name("availcounts"), availcounts_s> availcounts_t;
+
+    //Rolls of packs that mint their contents on unbox, every roll mints at most one asset
+    //id: pack_id in the high 32 bits, roll index in the low 32 bits
+    //thresholds and aliases are the Walker alias table of the odds: column i gives outcome i
+    //when a value drawn in [0, total_odds) is below thresholds[i], and outcome aliases[i] otherwise
+    TABLE packrolls_s {
+        uint64_t            id;
+        vector<OUTCOME>     outcomes;
+        vector<name>        schema_names;
+        uint64_t            total_odds;
+        vector<uint64_t>    thresholds;
+        vector<uint32_t>    aliases;
+
+        uint64_t primary_key() const { return id; }
+    };
+
+    typedef multi_index<name("packrolls"), packrolls_s> packrolls_t;
+
+    //Packs whose bundles are committed to with a merkle root instead of being stored in availpacks
+    //The tree has leaf_count leaves, padded with zero hashes up to the next power of two
+    TABLE packroots_s {
+        uint64_t            pack_id;
+        checksum256         root;
+        uint64_t            leaf_count;
+        uint64_t            used_count;
+
+        uint64_t primary_key() const { return pack_id; }
+    };
+
+    typedef multi_index<name("packroots"), packroots_s> packroots_t;
+
+    //Packs whose bundles are a range of pre-minted assets owned by the contract
+    //Slot i holds the assets_per_slot assets starting at first_asset_id + i * assets_per_slot
+    TABLE slotpools_s {
+        uint64_t            pack_id;
+        uint64_t            first_asset_id;
+        uint64_t            slot_count;
+        uint64_t            assets_per_slot;
+        uint64_t            used_count;
+
+        uint64_t primary_key() const { return pack_id; }
+    };
+
+    typedef multi_index<name("slotpools"), slotpools_s> slotpools_t;
+
+    //Bitmap of the used slots of a slot pool or of the used leaves of a merkle pack
+    //id: pack_id in the high 32 bits, chunk index in the low 32 bits, SLOTS_PER_CHUNK slots per chunk
+    TABLE slotchunks_s {
+        uint64_t            id;
+        vector<uint64_t>    words;
+
+        uint64_t primary_key() const { return id; }
+    };
+
+    typedef multi_index<name("slotchunks"), slotchunks_s> slotchunks_t;
+
+    //Fenwick tree over the used slots of the chunks, rows are only created once a count is non zero
+    //id: pack_id in the high 32 bits, 1 based tree node in the low 32 bits
+    TABLE slotsums_s {
+        uint64_t            id;
+        uint64_t            used;
+
+        uint64_t primary_key() const { return id; }
+    };
+
+    typedef multi_index<name("slotsums"), slotsums_s> slotsums_t;
+
+    //Leaf drawn for an unboxed merkle pack, waiting for its contents to be proven with claimproof
+    TABLE unboxleaves_s {
+        uint64_t            pack_asset_id;
+        uint64_t            leaf_index;
+
+        uint64_t primary_key() const { return pack_asset_id; }
+    };
+
+    typedef multi_index<name("unboxleaves"), unboxleaves_s> unboxleaves_t;
+
+    //Scope: pack_id
+    TABLE gencursor_s {
+        uint64_t            last_asset_id = 0;
+    };
+
+    typedef singleton<name("gencursor"), gencursor_s> gencursor_t;
+
+    //Scope: pack_id
+    //available: bundles, slots or leaves left to unbox, pending: unboxes waiting for the oracle
+    //unclaimed: resolved unboxes whose assets were not claimed yet, opened: packs burned by receiverand
+    TABLE stats_s {
+        uint64_t            available = 0;
+        uint64_t            pending = 0;
+        uint64_t            unclaimed = 0;
+        uint64_t            opened = 0;
+        uint32_t            last_oracle_time = 0;
+    };
+
+    typedef singleton<name("stats"), stats_s> stats_t;
+
     packs_t             packs           = packs_t(get_self(), get_self().value);
     unboxpacks_t        unboxpacks      = unboxpacks_t(get_self(), get_self().value);
     availpacks_t        availpacks      = availpacks_t(get_self(), get_self().value);
     avatarpacks_t       avatarpacks     = avatarpacks_t(get_self(), get_self().value);
+    availcounts_t       availcounts     = availcounts_t(get_self(), get_self().value);
+    unboxbatch_t        unboxbatch      = unboxbatch_t(get_self(), get_self().value);
+    packconfigs_t       packconfigs     = packconfigs_t(get_self(), get_self().value);
+    avatartmpls_t       avatartmpls     = avatartmpls_t(get_self(), get_self().value);
+    compactpacks_t      compactpacks    = compactpacks_t(get_self(), get_self().value);
+    assetranges_t       assetranges     = assetranges_t(get_self(), get_self().value);
+    shuffles_t          shuffles        = shuffles_t(get_self(), get_self().value);
+    packrolls_t         packrolls       = packrolls_t(get_self(), get_self().value);
+    packroots_t         packroots       = packroots_t(get_self(), get_self().value);
+    slotpools_t         slotpools       = slotpools_t(get_self(), get_self().value);
+    slotchunks_t        slotchunks      = slotchunks_t(get_self(), get_self().value);
+    slotsums_t          slotsums        = slotsums_t(get_self(), get_self().value);
+    unboxleaves_t       unboxleaves     = unboxleaves_t(get_self(), get_self().value);
+
+    //Expands the 256 bit oracle value into as many 64 bit values as needed
+    //The first four are read straight from random_value, the next ones from sha256(random_value, block)
+    struct random_stream {
+        array<uint8_t, 32>  seed;
+        array<uint8_t, 32>  block;
+        uint64_t            block_number = 0;
+        uint64_t            offset = 0;
+
+        random_stream(const checksum256 &random_value);
+        uint64_t next();
+    };
+
+    //Inclusive range of asset ids
+    struct ASSET_RANGE {
+        uint64_t            first_asset_id;
+        uint64_t            last_asset_id;
+    };
+
+    //Source a pack is unboxed from, see check_pack_mode_free
+    enum PACK_MODE : uint8_t {
+        MODE_NONE, MODE_BUNDLES, MODE_ROLLS, MODE_ROOT, MODE_POOL
+    };
 
     void check_has_collection_auth(name account_to_check, name collection_name);
 
-    const string COLLECTION_NAME = "clashdomenft";
-    const string CREATE_AVATAR_SCHEMA_NAME = "packs";
-    const uint32_t TEMPLATE_ID_1 = 336214;
-    const uint32_t TEMPLATE_ID_2 = 336216;
-    const uint32_t TEMPLATE_ID_3 = 336217;
+    packconfigs_s get_packconfig(uint64_t pack_id);
+
+    template<typename F>
+    void update_stats(uint64_t pack_id, F &&updater);
+    void decrease_unclaimed(uint64_t pack_id);
+    string get_avatar_rarity(int32_t template_id);
+
+    template<typename T>
+    uint64_t erase_rows(T &table, uint64_t max_rows);
+
+    template<typename T, typename I>
+    typename I::const_iterator seek_unboxer(T &table, I &idx, name unboxer, uint64_t cursor);
+
+    void check_pack_mode_free(uint64_t pack_id, PACK_MODE mode);
+    bool has_rolls(uint64_t pack_id);
+
+    static uint64_t pack_key(uint64_t pack_id, uint64_t index);
+    static vector<uint8_t> encode_bundle(const vector<uint64_t> &assets_ids);
+    static vector<uint64_t> decode_bundle(const vector<uint8_t> &data);
+    vector<uint64_t> read_availpack(uint64_t id);
+    void write_availpack(uint64_t id, const vector<uint64_t> &assets_ids);
+    vector<uint64_t> erase_availpack(uint64_t id);
+    assetranges_t::const_iterator find_asset_range(uint64_t first_asset_id, uint64_t last_asset_id);
+    void bundle_asset(uint64_t asset_id);
+    void unbundle_assets(const vector<uint64_t> &assets_ids);
+    vector<ASSET_RANGE> slot_pool_ranges(uint64_t skipped_pack_id);
+    static bool in_asset_ranges(const vector<ASSET_RANGE> &ranges, uint64_t asset_id);
+    static uint64_t shuffle_value(const checksum256 &seed, uint64_t position);
+    uint64_t push_availpacks(uint64_t pack_id, const vector<vector<uint64_t>> &bundles);
+    vector<uint64_t> take_availpack(availcounts_t::const_iterator counts_itr, uint64_t position);
+
+    vector<int32_t> roll_pack(uint64_t pack_id, name unboxer, random_stream &random);
+
+    template<typename T>
+    uint64_t erase_slot_packs(T &table, uint64_t max_rows);
+    uint64_t erase_slot_rows(uint64_t pack_id, uint64_t max_rows);
+    bool has_slot_rows(uint64_t pack_id);
+    uint64_t take_slot(uint64_t pack_id, uint64_t slot_count, uint64_t used_count, uint64_t random_int);
+    static checksum256 leaf_hash(uint64_t pack_id, uint64_t leaf_index, const vector<uint64_t> &assets_ids);
+    static checksum256 node_hash(const checksum256 &left, const checksum256 &right);
+
+    static constexpr name COLLECTION_NAME = name("clashdomenft");
+    static constexpr name CREATE_AVATAR_SCHEMA_NAME = name("packs");
+    static constexpr name AVATAR_SCHEMA_NAME = name("citizen");
+    static constexpr name CONTENT_SCHEMA_NAME = name("poolhalls");
+
+    //Rarities of the original avatar templates, used for templates without an avatartmpls row
+    struct AVATAR_RARITY {
+        int32_t             template_id;
+        const char          *rarity;
+    };
+
+    static constexpr AVATAR_RARITY DEFAULT_AVATAR_RARITIES[] = {
+        {336214, "Pleb"},
+        {336216, "UberNorm"},
+        {336217, "Hi-Clone"}
+    };
+
+    static constexpr uint64_t MAX_UNBOX_PACKS = 30;
+    static constexpr uint64_t MAX_PAGE_ROWS = 100;
+
+    static constexpr uint64_t SLOTS_PER_CHUNK = 1024;
+
+    //Smallest number of positions a pre-shuffled pack unboxes from, see commitshuf
+    static constexpr uint64_t MIN_SHUFFLE_WINDOW = 64;
 
 };
\ No newline at end of file
@@ -38,8 +38,8 @@ ACTION packsopener::createavatar(
         name("mintasset"),
         std::make_tuple(
             get_self(),
-            name(COLLECTION_NAME),
-            name("citizen"),
+            COLLECTION_NAME,
+            AVATAR_SCHEMA_NAME,
             template_id,
             unboxer,
             attr_map,
@@ -91,6 +91,50 @@ ACTION packsopener::unstakeav(
     avatarpacks.erase(avatarpacks_itr);
 }
 
+/**
+* Registers a template of the avatar schema that can be staked with "unbox avatar"
+* Either rarity is stored as is, or rarity_attribute names the string attribute of the
+* template's immutable data that holds it
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::setavtmpl(
+    int32_t template_id,
+    string rarity,
+    string rarity_attribute
+) {
+    require_auth(get_self());
+
+    check(template_id >= 0, "Invalid template id");
+    check(rarity.empty() != rarity_attribute.empty(), "Either rarity or rarity_attribute needs to be set");
+
+    auto avatartmpl_itr = avatartmpls.find((uint64_t) template_id);
+
+    if (avatartmpl_itr == avatartmpls.end()) {
+        avatartmpls.emplace(get_self(), [&](auto &_avatartmpl) {
+            _avatartmpl.template_id = template_id;
+            _avatartmpl.rarity = rarity;
+            _avatartmpl.rarity_attribute = rarity_attribute;
+        });
+    } else {
+        avatartmpls.modify(avatartmpl_itr, get_self(), [&](auto &_avatartmpl) {
+            _avatartmpl.rarity = rarity;
+            _avatartmpl.rarity_attribute = rarity_attribute;
+        });
+    }
+}
+
+ACTION packsopener::delavtmpl(
+    int32_t template_id
+) {
+    require_auth(get_self());
+
+    auto avatartmpl_itr = avatartmpls.require_find((uint64_t) template_id,
+        "No avatar template with this id exists");
+
+    avatartmpls.erase(avatartmpl_itr);
+}
+
 /**
 * Funcion from atomicpacks contract
 *
@@ -137,407 +181,2147 @@ ACTION packsopener::createpack(
 }
 
 /**
-* Funcion from atomicpacks contract
+* Sets the unbox options of a pack
+* With auto_claim the unboxed assets are transferred to the unboxer by receiverand itself,
+* without an unboxpacks result row and without the claimunboxed transaction
+* With compact the bundles added from now on are stored varint encoded in compactpacks,
+* existing bundles can be moved there with migratepacks
 *
-* This action is called by the rng oracle and provides the randomness for unboxing a pack
-* The assoc id is equal to the asset id of the pack that is being unboxed
-* 
-* The unboxed assets are not immediately minted but instead placed in the unboxassets table with
-* the scope <asset id of the pack that is being unboxed> and need to be claimed using the claimunboxed action
-* This functionality is split in an effort to prevent transaction timeouts
-* 
-* @required_auth rng oracle account
+* @required_auth The contract itself
 */
-ACTION packsopener::receiverand(
-    uint64_t assoc_id,
-    checksum256 random_value
+ACTION packsopener::setpackcfg(
+    uint64_t pack_id,
+    bool auto_claim,
+    bool compact
 ) {
+    require_auth(get_self());
 
-    require_auth(name("orng.wax"));
-    // require_auth(get_self());
+    packs.require_find(pack_id, "No pack with this id exists");
+
+    auto config_itr = packconfigs.find(pack_id);
 
-    // get all available packs 
-    auto unboxpack_itr = unboxpacks.find(assoc_id);
+    if (config_itr == packconfigs.end()) {
+        packconfigs.emplace(get_self(), [&](auto &_config) {
+            _config.pack_id = pack_id;
+            _config.auto_claim = auto_claim;
+            _config.compact = compact;
+        });
+    } else {
+        packconfigs.modify(config_itr, get_self(), [&](auto &_config) {
+            _config.auto_claim = auto_claim;
+            _config.compact = compact;
+        });
+    }
+}
 
-    auto idx = availpacks.get_index<"packid"_n>();
+/**
+* Funcion from atomicpacks contract
+*
+* Adds a roll to a pack. Each roll of a pack mints at most one asset when the pack is unboxed,
+* picked with the given odds. The odds are compiled here into a Walker alias table,
+* so drawing a roll on unbox takes two random values and no search, whatever the number of outcomes
+*
+* The contract mints the outcomes, so it needs to be authorized within the collection of the pack
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::addpackroll(
+    uint64_t pack_id,
+    vector<OUTCOME> outcomes
+) {
+    require_auth(get_self());
 
-    auto itr = idx.lower_bound(unboxpack_itr->pack_id);
+    auto pack_itr = packs.require_find(pack_id, "No pack with this id exists");
 
-    vector<uint64_t> availables;
+    check_has_collection_auth(get_self(), pack_itr->collection_name);
 
-    while (itr != idx.end() && itr->pack_id == unboxpack_itr->pack_id) {
-        availables.push_back(itr->id);
-        itr++;
-    } 
+    check(outcomes.size() > 0 && outcomes.size() <= 0xFFFFFFFF, "A roll needs to have at least one outcome");
 
-    check(availables.size() > 0, "No assets availables.");
+    check_pack_mode_free(pack_id, MODE_ROLLS);
 
-    //cast the random_value to a smaller number
-    uint64_t max_value = availables.size() - 1;
-    uint64_t final_random_value = 0;
+    atomicassets::templates_t collection_templates = atomicassets::get_templates(pack_itr->collection_name);
 
-    if (max_value > 0) {
+    uint64_t total_odds = 0;
+    vector<name> schema_names;
 
-        auto byte_array = random_value.extract_as_byte_array();
+    for (const OUTCOME &outcome : outcomes) {
+        check(outcome.odds > 0, "The odds of an outcome need to be greater than 0");
+        total_odds += outcome.odds;
 
-        uint64_t random_int = 0;
-        for (int i = 0; i < 8; i++) {
-            random_int <<= 8;
-            random_int |= (uint64_t)byte_array[i];
+        if (outcome.template_id == -1) {
+            schema_names.push_back(name());
+        } else {
+            auto template_itr = collection_templates.require_find((uint64_t) outcome.template_id,
+                ("No template with the id " + to_string(outcome.template_id) + " exists in the collection").c_str());
+            schema_names.push_back(template_itr->schema_name);
         }
-
-        final_random_value = random_int % max_value;   
     }
 
-    uint64_t selected_pack = availables[final_random_value];
+    // Vose's alias method on integers: outcome i has the weight odds_i * n out of total_odds per column
+    uint64_t n = outcomes.size();
+    vector<uint64_t> thresholds(n);
+    vector<uint32_t> aliases(n);
+    vector<uint64_t> small, large;
 
-    auto available_itr = availpacks.find(selected_pack);
-
-    unboxpacks.modify(unboxpack_itr, get_self(), [&](auto &_pack) {
-        _pack.assets_ids = available_itr->assets_ids;
-    });
+    for (uint64_t i = 0; i < n; i++) {
+        thresholds[i] = (uint64_t) outcomes[i].odds * n;
+        aliases[i] = i;
+        (thresholds[i] < total_odds ? small : large).push_back(i);
+    }
 
-    availpacks.erase(available_itr);
+    while (!small.empty() && !large.empty()) {
+        uint64_t less = small.back();
+        uint64_t more = large.back();
+        small.pop_back();
 
-    action(
-        permission_level{get_self(), name("active")},
-        get_self(),
-        name("loggetrand"),
-        std::make_tuple(
-            assoc_id,
-            max_value,
-            final_random_value,
-            available_itr->assets_ids
-        )
-    ).send();
+        // the column of less is topped up with more
+        aliases[less] = more;
+        thresholds[more] -= total_odds - thresholds[less];
 
-    // burn the pack
-    action(
-        permission_level{get_self(), name("active")},
-        atomicassets::ATOMICASSETS_ACCOUNT,
-        name("burnasset"),
-        std::make_tuple(
-            get_self(),
-            assoc_id
-        )
-    ).send();
-}
+        if (thresholds[more] < total_odds) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
 
-ACTION packsopener::addpack(
-    uint64_t pack_id,
-    vector<uint64_t> assets_ids
-) {
-    require_auth(get_self());
+    // what is left fills its own column
+    for (uint64_t i : large) {
+        thresholds[i] = total_odds;
+    }
+    for (uint64_t i : small) {
+        thresholds[i] = total_odds;
+    }
 
-    uint64_t id = availpacks.available_primary_key();
-    if (id == 0) {
-        id = 1;
+    uint64_t roll_index = 0;
+    auto last_roll_itr = packrolls.lower_bound(pack_key(pack_id + 1, 0));
+    if (last_roll_itr != packrolls.begin()) {
+        last_roll_itr--;
+        if (last_roll_itr->id >> 32 == pack_id) {
+            roll_index = (last_roll_itr->id & 0xFFFFFFFF) + 1;
+        }
     }
 
-    availpacks.emplace(get_self(), [&](auto &_availpack) {
-        _availpack.id = id;
-        _availpack.pack_id = pack_id;
-        _availpack.assets_ids = assets_ids;
+    packrolls.emplace(get_self(), [&](auto &_roll) {
+        _roll.id = pack_key(pack_id, roll_index);
+        _roll.outcomes = outcomes;
+        _roll.schema_names = schema_names;
+        _roll.total_odds = total_odds;
+        _roll.thresholds = thresholds;
+        _roll.aliases = aliases;
     });
 }
 
-ACTION packsopener::genpacks(
-    name authorized_account,
-    uint64_t pack_template_id
+/**
+* Commits the bundles of a pack to a merkle root instead of storing them in availpacks
+* Leaf i of the tree is sha256(0x00, pack_id, i, asset ids) with every number as 8 little endian bytes,
+* inner nodes are sha256(0x01, left, right). The leaves are padded with zero hashes up to the next power of two.
+* The root can be replaced as long as no leaf was unboxed
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::setpackroot(
+    uint64_t pack_id,
+    checksum256 root,
+    uint64_t leaf_count
 ) {
-
     require_auth(get_self());
 
-    auto idx = packs.get_index<"templateid"_n>();
-
-    auto itr = idx.require_find(pack_template_id, 
-        "No pack with this template exists");
-    
-    check_has_collection_auth(authorized_account, itr->collection_name);
-    check_has_collection_auth(get_self(), itr->collection_name);
-
-    atomicassets::assets_t own_assets = atomicassets::get_assets(get_self());
+    packs.require_find(pack_id, "No pack with this id exists");
 
-    auto assets_itr = own_assets.begin();
+    check(leaf_count > 0 && leaf_count <= 0x100000000, "leaf_count needs to be between 1 and 2^32");
 
-    while(assets_itr != own_assets.end()) {
+    check_pack_mode_free(pack_id, MODE_ROOT);
 
-        if (assets_itr->collection_name == itr->collection_name && assets_itr->schema_name == name("poolhalls")) {
+    auto root_itr = packroots.find(pack_id);
 
-            uint64_t id = availpacks.available_primary_key();
-            if (id == 0) {
-                id = 1;
-            }
+    if (root_itr == packroots.end()) {
+        check(!has_slot_rows(pack_id), "The pack still has used slots, remove slotchunks and slotsums first");
 
-            vector<uint64_t> vec;
-            vec.push_back(assets_itr->asset_id);
+        packroots.emplace(get_self(), [&](auto &_root) {
+            _root.pack_id = pack_id;
+            _root.root = root;
+            _root.leaf_count = leaf_count;
+            _root.used_count = 0;
+        });
+    } else {
+        check(root_itr->used_count == 0, "Leaves of this pack were already unboxed");
 
-            availpacks.emplace(get_self(), [&](auto &_availpack) {
-                _availpack.id = id;
-                _availpack.pack_id = itr->pack_id;
-                _availpack.assets_ids = vec;
-            });
-        }
-        
-        assets_itr ++;
+        packroots.modify(root_itr, get_self(), [&](auto &_root) {
+            _root.root = root;
+            _root.leaf_count = leaf_count;
+        });
     }
+
+    update_stats(pack_id, [&](auto &_stats) {
+        _stats.available = leaf_count;
+    });
 }
 
-ACTION packsopener::claimunboxed(
-    uint64_t pack_asset_id
+/**
+* Backs a pack with a range of pre-minted assets instead of bundles in availpacks
+* The assets first_asset_id to first_asset_id + slot_count * assets_per_slot - 1 need to be owned by the contract,
+* and can be neither in an available pack nor in the slot pool of another pack.
+* Each unbox picks one of the unused slots uniformly, with a fixed number of row reads whatever the pool size
+* The range can be replaced as long as no slot was unboxed
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::setslotpool(
+    uint64_t pack_id,
+    uint64_t first_asset_id,
+    uint64_t slot_count,
+    uint64_t assets_per_slot
 ) {
+    require_auth(get_self());
 
-    auto unboxpack_itr = unboxpacks.require_find(pack_asset_id,
-        "No unboxpack with this pack asset id exists");
+    packs.require_find(pack_id, "No pack with this id exists");
 
-    check(has_auth(unboxpack_itr->unboxer) || has_auth(get_self()),
-        "The transaction needs to be authorized either by the unboxer or by the contract itself");
+    check(slot_count > 0 && slot_count <= 0x100000000, "slot_count needs to be between 1 and 2^32");
+    check(assets_per_slot > 0, "assets_per_slot needs to be greater than 0");
 
-    action(
-        permission_level{get_self(), name("active")},
-        atomicassets::ATOMICASSETS_ACCOUNT,
-        name("transfer"),
-        std::make_tuple(
-            get_self(),
-            unboxpack_itr->unboxer,
-            unboxpack_itr->assets_ids,
-            "claim unbox pack " + to_string(pack_asset_id)
-        )
-    ).send();
+    check_pack_mode_free(pack_id, MODE_POOL);
 
-    unboxpacks.erase(unboxpack_itr);
-}
+    check(assets_per_slot <= (0xFFFFFFFFFFFFFFFF - first_asset_id) / slot_count, "The asset range overflows");
+    uint64_t last_asset_id = first_asset_id + slot_count * assets_per_slot - 1;
 
-ACTION packsopener::removeall(
-    string table
-) {
+    // an asset can only be promised by one pack
+    check(find_asset_range(first_asset_id, last_asset_id) == assetranges.end(),
+        "The asset range overlaps assets that are already in an available pack");
 
-    require_auth(get_self());
+    for (const ASSET_RANGE &range : slot_pool_ranges(pack_id)) {
+        check(range.last_asset_id < first_asset_id || range.first_asset_id > last_asset_id,
+            "The asset range overlaps the slot pool of another pack");
+    }
 
-    if (table == "packs") {
-        auto it = packs.begin();
-        while (it != packs.end()) {
-            it = packs.erase(it);
-        }
-    } else if (table == "unboxpacks") {
-        auto it = unboxpacks.begin();
-        while (it != unboxpacks.end()) {
-            it = unboxpacks.erase(it);
-        }
-    } else if (table == "availpacks") {
-        auto it = availpacks.begin();
-        while (it != availpacks.end()) {
-            it = availpacks.erase(it);
-        }
-    } else if (table == "avatarpacks") {
-        auto it = avatarpacks.begin();
-        while (it != avatarpacks.end()) {
-            it = avatarpacks.erase(it);
-        }
+    auto pool_itr = slotpools.find(pack_id);
+
+    if (pool_itr == slotpools.end()) {
+        check(!has_slot_rows(pack_id), "The pack still has used slots, remove slotchunks and slotsums first");
+
+        slotpools.emplace(get_self(), [&](auto &_pool) {
+            _pool.pack_id = pack_id;
+            _pool.first_asset_id = first_asset_id;
+            _pool.slot_count = slot_count;
+            _pool.assets_per_slot = assets_per_slot;
+            _pool.used_count = 0;
+        });
+    } else {
+        check(pool_itr->used_count == 0, "Slots of this pack were already unboxed");
+
+        slotpools.modify(pool_itr, get_self(), [&](auto &_pool) {
+            _pool.first_asset_id = first_asset_id;
+            _pool.slot_count = slot_count;
+            _pool.assets_per_slot = assets_per_slot;
+        });
     }
+
+    update_stats(pack_id, [&](auto &_stats) {
+        _stats.available = slot_count;
+    });
 }
 
-ACTION packsopener::lognewpack(
+/**
+* Makes a pack pre-shuffled. commitment is the sha256 of a 32 byte seed that is kept secret until
+* revealshuf. Once revealed, the seed shuffles every bundle loaded with addpack, addpacks or genpacks,
+* so anyone can recompute the order of the inventory from the seed and the loaded bundles
+* Unboxes then pick one of the last window positions, which needs a fixed number of row reads
+*
+* availpacks is public, so the last window bundles are known to everyone: an unbox gets each of them
+* with a chance of 1 / window and nothing else. A small window keeps unboxes close to the audited order
+* but lets users time their unboxes to take the bundles they want, so window is at least MIN_SHUFFLE_WINDOW.
+* Once the inventory is no larger than window, unboxes pick uniformly over all of it
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::commitshuf(
     uint64_t pack_id,
-    name collection_name,
-    uint32_t unlock_time
+    checksum256 commitment,
+    uint64_t window
 ) {
     require_auth(get_self());
-}
 
-ACTION packsopener::loggetrand(
-    uint64_t assoc_id,
-    uint64_t max_value,
-    uint64_t rand_value,
-    vector<uint64_t> vec
-) {
-    require_auth(get_self());
-}
+    packs.require_find(pack_id, "No pack with this id exists");
 
-ACTION packsopener::loggenpacks(
-    name authorized_account,
-    uint64_t pack_template_id,
-    vector<uint64_t> vec
-) {
-    require_auth(get_self());
+    check(window >= MIN_SHUFFLE_WINDOW, "window needs to be at least " + to_string(MIN_SHUFFLE_WINDOW));
+
+    // the shuffle only applies to bundles loaded after the seed is revealed
+    check_pack_mode_free(pack_id, MODE_NONE);
+
+    auto shuffle_itr = shuffles.find(pack_id);
+
+    if (shuffle_itr == shuffles.end()) {
+        shuffles.emplace(get_self(), [&](auto &_shuffle) {
+            _shuffle.pack_id = pack_id;
+            _shuffle.commitment = commitment;
+            _shuffle.revealed = false;
+            _shuffle.window = window;
+        });
+    } else {
+        shuffles.modify(shuffle_itr, get_self(), [&](auto &_shuffle) {
+            _shuffle.commitment = commitment;
+            _shuffle.seed = checksum256();
+            _shuffle.revealed = false;
+            _shuffle.window = window;
+        });
+    }
 }
 
 /**
-* Requests new randomness for a given assoc_id
-* This is supposed to be used in the rare case that the RNG oracle kills a job for a pack unboxing
-* due to issues with the finisher script.
+* Reveals the seed committed to with commitshuf, after which bundles can be loaded
 *
 * @required_auth The contract itself
 */
-ACTION packsopener::retryrand(
-    uint64_t pack_asset_id
+ACTION packsopener::revealshuf(
+    uint64_t pack_id,
+    checksum256 seed
 ) {
     require_auth(get_self());
 
-    auto pack_itr = unboxpacks.require_find(pack_asset_id,
-        "No open unboxpacks entry with the specified pack asset id exists");
-    
-    check(pack_itr->assets_ids.empty(),
-        "The specified pack asset id already has results");
-
-    //Get signing value from transaction id
-    //As this is only used as the signing value for the randomness oracle, it does not matter that this
-    //signing value is not truly random
-
-    auto size = transaction_size();
-    char buf[size];
-
-    auto read = read_transaction(buf, size);
-    check(size == read, "read_transaction() has failed.");
-
-    checksum256 tx_id = eosio::sha256(buf, read);
+    auto shuffle_itr = shuffles.require_find(pack_id, "The pack has no shuffle commitment");
 
-    uint64_t signing_value;
+    check(!shuffle_itr->revealed, "The seed was already revealed");
 
-    memcpy(&signing_value, tx_id.data(), sizeof(signing_value));
+    auto seed_bytes = seed.extract_as_byte_array();
+    check(eosio::sha256((const char *) seed_bytes.data(), seed_bytes.size()) == shuffle_itr->commitment,
+        "The seed does not match the commitment");
 
-    action(
-        permission_level{get_self(), name("active")},
-        name("orng.wax"),
-        name("requestrand"),
-        std::make_tuple(
-            pack_asset_id, //used as assoc id
-            signing_value,
-            get_self()
-        )
-    ).send();
+    shuffles.modify(shuffle_itr, get_self(), [&](auto &_shuffle) {
+        _shuffle.seed = seed;
+        _shuffle.revealed = true;
+    });
 }
 
 /**
 * Funcion from atomicpacks contract
 *
-* This function is called when AtomicAssets assets are transferred to the pack contract
-
-* This is used to unbox packs, by transferring exactly one pack to the pack contract
-* The pack asset is then burned and the rng oracle is called to request a random value
+* This action is called by the rng oracle and provides the randomness for unboxing a pack
+* The assoc id is equal to the asset id of the pack that is being unboxed, or to the first one
+* when several packs were unboxed with one transfer. Each pack then gets its own 64 bit slice of random_value
+* 
+* The unboxed assets are not immediately minted but instead placed in the unboxassets table with
+* the scope <asset id of the pack that is being unboxed> and need to be claimed using the claimunboxed action
+* This functionality is split in an effort to prevent transaction timeouts
+* Packs configured with auto_claim skip that step: their assets are transferred here, in one transfer per call
+* Packs with a merkle root only get a leaf index here, in unboxleaves, and are claimed with claimproof
+* Packs with rolls mint one outcome per roll to the unboxer and log them with logrolls instead of loggetrand
+* 
+* @required_auth rng oracle account
 */
-void packsopener::receive_asset_transfer(
-    name from,
-    name to,
-    vector <uint64_t> asset_ids,
-    string memo
+ACTION packsopener::receiverand(
+    uint64_t assoc_id,
+    checksum256 random_value
 ) {
-    if (to != get_self()) {
-        return;
-    }
 
-    if (memo == "unbox") {
+    require_auth(name("orng.wax"));
+    // require_auth(get_self());
 
-        check(asset_ids.size() == 1, "Only one pack can be opened at a time");
+    // packs unboxed alone have no batch row
+    vector<uint64_t> pack_asset_ids = {assoc_id};
 
-        atomicassets::assets_t own_assets = atomicassets::get_assets(get_self());
-        auto asset_itr = own_assets.find(asset_ids[0]);
+    auto batch_itr = unboxbatch.find(assoc_id);
+    if (batch_itr != unboxbatch.end()) {
+        pack_asset_ids = batch_itr->pack_asset_ids;
+        unboxbatch.erase(batch_itr);
+    }
 
-        check(asset_itr->template_id != -1, "The transferred asset does not belong to a template");
-        
-        auto packs_by_template_id = packs.get_index<name("templateid")>();
-        auto pack_itr = packs_by_template_id.require_find(asset_itr->template_id,
-            "The transferred asset's template does not belong to any pack");
-        
-        check(pack_itr->unlock_time <= current_time_point().sec_since_epoch(), "The pack has not unlocked yet");
+    random_stream random(random_value);
 
-        //Get signing value from transaction id
-        //As this is only used as the signing value for the randomness oracle, it does not matter that this
-        //signing value is not truly random
+    // all packs of a batch come from the same transfer, so they share the unboxer
+    name unboxer;
+    vector<uint64_t> delivered_assets_ids;
 
-        auto size = transaction_size();
-        char buf[size];
+    packconfigs_s config = {0, false, false};
 
-        auto read = read_transaction(buf, size);
-        check(size == read, "read_transaction() has failed.");
+    uint32_t oracle_time = current_time_point().sec_since_epoch();
 
-        checksum256 tx_id = eosio::sha256(buf, read);
+    for (uint64_t pack_asset_id : pack_asset_ids) {
 
-        uint64_t signing_value;
+        auto unboxpack_itr = unboxpacks.require_find(pack_asset_id,
+            "No unboxpack with this pack asset id exists");
 
-        memcpy(&signing_value, tx_id.data(), sizeof(signing_value));
+        // already resolved by a retried request
+        if (!unboxpack_itr->assets_ids.empty() || unboxleaves.find(pack_asset_id) != unboxleaves.end()) {
+            continue;
+        }
+
+        if (config.pack_id != unboxpack_itr->pack_id) {
+            config = get_packconfig(unboxpack_itr->pack_id);
+        }
+
+        uint64_t max_value = 0;
+        uint64_t final_random_value = 0;
+        vector<uint64_t> assets_ids;
+
+        auto root_itr = packroots.find(unboxpack_itr->pack_id);
+
+        bool rolled = has_rolls(unboxpack_itr->pack_id);
+
+        if (rolled) {
+            // the outcomes are minted straight to the unboxer, there is nothing left to claim
+            vector<int32_t> template_ids = roll_pack(unboxpack_itr->pack_id, unboxpack_itr->unboxer, random);
+
+            action(
+                permission_level{get_self(), name("active")},
+                get_self(),
+                name("logrolls"),
+                std::make_tuple(
+                    pack_asset_id,
+                    unboxpack_itr->unboxer,
+                    template_ids
+                )
+            ).send();
+
+            unboxpacks.erase(unboxpack_itr);
+        } else if (root_itr != packroots.end()) {
+            // only a leaf is drawn, its contents are revealed and proven with claimproof
+            check(root_itr->used_count < root_itr->leaf_count, "No assets availables.");
+
+            max_value = root_itr->leaf_count - 1;
+            final_random_value = take_slot(root_itr->pack_id, root_itr->leaf_count, root_itr->used_count, random.next());
+
+            packroots.modify(root_itr, get_self(), [&](auto &_root) {
+                _root.used_count++;
+            });
+
+            unboxleaves.emplace(get_self(), [&](auto &_unboxleaf) {
+                _unboxleaf.pack_asset_id = pack_asset_id;
+                _unboxleaf.leaf_index = final_random_value;
+            });
+        } else {
+            auto pool_itr = slotpools.find(unboxpack_itr->pack_id);
+
+            if (pool_itr != slotpools.end()) {
+                check(pool_itr->used_count < pool_itr->slot_count, "No assets availables.");
+
+                max_value = pool_itr->slot_count - 1;
+                final_random_value = take_slot(pool_itr->pack_id, pool_itr->slot_count, pool_itr->used_count, random.next());
+
+                slotpools.modify(pool_itr, get_self(), [&](auto &_pool) {
+                    _pool.used_count++;
+                });
+
+                uint64_t first_asset_id = pool_itr->first_asset_id + final_random_value * pool_itr->assets_per_slot;
+                for (uint64_t i = 0; i < pool_itr->assets_per_slot; i++) {
+                    assets_ids.push_back(first_asset_id + i);
+                }
+            } else {
+                // the inventory of the pack is dense, so the random value maps directly to one position
+                auto counts_itr = availcounts.find(unboxpack_itr->pack_id);
+
+                check(counts_itr != availcounts.end() && counts_itr->count > 0, "No assets availables.");
+
+                //cast the random_value to a smaller number
+                max_value = counts_itr->count - 1;
+
+                uint64_t random_int = random.next();
+
+                // pre-shuffled packs only pick among the last positions of the inventory,
+                // and over all of it once it fits in the window
+                auto shuffle_itr = shuffles.find(unboxpack_itr->pack_id);
+                if (shuffle_itr != shuffles.end() && shuffle_itr->window < counts_itr->count) {
+                    final_random_value = counts_itr->count - 1 - random_int % shuffle_itr->window;
+                } else if (max_value > 0) {
+                    final_random_value = random_int % counts_itr->count;
+                }
 
-        //It is not necessary to check the necessary RAM because the content of the packs is pre-mined
+                assets_ids = take_availpack(counts_itr, final_random_value);
+            }
+
+            if (config.auto_claim) {
+                unboxer = unboxpack_itr->unboxer;
+                delivered_assets_ids.insert(delivered_assets_ids.end(), assets_ids.begin(), assets_ids.end());
+
+                unboxpacks.erase(unboxpack_itr);
+            } else {
+                unboxpacks.modify(unboxpack_itr, get_self(), [&](auto &_pack) {
+                    _pack.assets_ids = assets_ids;
+                });
+            }
+        }
+
+        // rolled packs have no limited inventory and leave nothing to claim, merkle packs are claimed with a proof
+        bool unclaimed = !rolled && (root_itr != packroots.end() || !config.auto_claim);
 
-        unboxpacks.emplace(get_self(), [&](auto &_unboxpack) {
-            _unboxpack.pack_asset_id = asset_ids[0];
-            _unboxpack.pack_id = pack_itr->pack_id;
-            _unboxpack.unboxer = from;
+        update_stats(config.pack_id, [&](auto &_stats) {
+            if (_stats.pending > 0) {
+                _stats.pending--;
+            }
+            if (!rolled && _stats.available > 0) {
+                _stats.available--;
+            }
+            if (unclaimed) {
+                _stats.unclaimed++;
+            }
+            _stats.opened++;
+            _stats.last_oracle_time = oracle_time;
         });
 
+        if (!rolled) {
+            action(
+                permission_level{get_self(), name("active")},
+                get_self(),
+                name("loggetrand"),
+                std::make_tuple(
+                    pack_asset_id,
+                    max_value,
+                    final_random_value,
+                    assets_ids
+                )
+            ).send();
+        }
+
+        // burn the pack
         action(
             permission_level{get_self(), name("active")},
-            name("orng.wax"),
-            name("requestrand"),
+            atomicassets::ATOMICASSETS_ACCOUNT,
+            name("burnasset"),
             std::make_tuple(
-                asset_ids[0], //used as assoc id
-                signing_value,
-                get_self()
+                get_self(),
+                pack_asset_id
             )
         ).send();
-    } else if (memo == "unbox avatar") {
+    }
 
-        check(asset_ids.size() == 1, "Only one pack can be opened at a time.");
+    if (delivered_assets_ids.size() > 0) {
+        action(
+            permission_level{get_self(), name("active")},
+            atomicassets::ATOMICASSETS_ACCOUNT,
+            name("transfer"),
+            std::make_tuple(
+                get_self(),
+                unboxer,
+                delivered_assets_ids,
+                "unbox pack " + to_string(assoc_id)
+            )
+        ).send();
 
-        auto idx = avatarpacks.get_index<"unboxer"_n>();
-        
-        auto itr = idx.find(from.value); 
+        unbundle_assets(delivered_assets_ids);
+    }
+}
 
-        check(itr == idx.end(), "YOU CAN ONLY STAKE ONE AMNIO-TANK AT ONCE.");
+ACTION packsopener::addpack(
+    uint64_t pack_id,
+    vector<uint64_t> assets_ids
+) {
+    require_auth(get_self());
 
-        atomicassets::assets_t own_assets = atomicassets::get_assets(get_self());
-        auto asset_itr = own_assets.find(asset_ids[0]);
+    push_availpacks(pack_id, {assets_ids});
+}
+
+/**
+* Bulk version of addpack, appends every bundle to the inventory of the pack in one pass
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::addpacks(
+    uint64_t pack_id,
+    vector<vector<uint64_t>> bundles
+) {
+    require_auth(get_self());
 
-        check(asset_itr->collection_name == name(COLLECTION_NAME), "NFT doesn't correspond to " + COLLECTION_NAME);
-        check(asset_itr->schema_name == name(CREATE_AVATAR_SCHEMA_NAME), "NFT doesn't correspond to schema " + CREATE_AVATAR_SCHEMA_NAME);
-        check(asset_itr->template_id == TEMPLATE_ID_1 || asset_itr->template_id == TEMPLATE_ID_2 || asset_itr->template_id == TEMPLATE_ID_3 , "NFT doesn't correspond to template ids.");
+    check(bundles.size() > 0, "No bundles to add");
 
-        atomicassets::schemas_t collection_schemas = atomicassets::get_schemas(name(COLLECTION_NAME));
-        auto schema_itr = collection_schemas.find(name(CREATE_AVATAR_SCHEMA_NAME).value);
+    uint64_t available = push_availpacks(pack_id, bundles);
 
-        atomicassets::templates_t collection_templates = atomicassets::get_templates(name(COLLECTION_NAME));
-        auto template_itr = collection_templates.find(asset_itr->template_id);
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logaddpacks"),
+        std::make_tuple(
+            pack_id,
+            (uint64_t) bundles.size(),
+            available
+        )
+    ).send();
+}
 
-        vector <uint8_t> immutable_serialized_data = template_itr->immutable_serialized_data;
+/**
+* Bundles the "poolhalls" assets owned by the contract into available packs
+* Assets are scanned in asset id order, at most max_assets per call. The last scanned asset id
+* is saved in the gencursor singleton of the pack, so the next call resumes where this one stopped
+* and assets received later are picked up by calling it again.
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::genpacks(
+    name authorized_account,
+    uint64_t pack_template_id,
+    uint64_t max_assets
+) {
 
-        atomicassets::ATTRIBUTE_MAP idata = atomicdata::deserialize(immutable_serialized_data, schema_itr->format);
-        
-        string rarity = "";
+    require_auth(get_self());
 
-        if (asset_itr->template_id == TEMPLATE_ID_1) {
-            rarity = "Pleb";
-        } else if (asset_itr->template_id == TEMPLATE_ID_2) {
-            rarity = "UberNorm";
-        }  else if (asset_itr->template_id == TEMPLATE_ID_3) {
-            rarity = "Hi-Clone";
+    check(max_assets > 0, "max_assets needs to be greater than 0");
+
+    auto idx = packs.get_index<"templateid"_n>();
+
+    auto itr = idx.require_find(pack_template_id, 
+        "No pack with this template exists");
+    
+    check_has_collection_auth(authorized_account, itr->collection_name);
+    check_has_collection_auth(get_self(), itr->collection_name);
+
+    gencursor_t gencursor = gencursor_t(get_self(), itr->pack_id);
+    gencursor_s cursor = gencursor.get_or_default();
+
+    atomicassets::assets_t own_assets = atomicassets::get_assets(get_self());
+
+    auto assets_itr = own_assets.upper_bound(cursor.last_asset_id);
+
+    uint64_t scanned = 0;
+    vector<vector<uint64_t>> bundles;
+
+    vector<ASSET_RANGE> pool_ranges = slot_pool_ranges(0);
+
+    while(assets_itr != own_assets.end() && scanned < max_assets) {
+
+        // assets bundled by an earlier call or by addpacks are skipped, so the scan can be run again safely,
+        // and so are the assets reserved by slot pools
+        if (assets_itr->collection_name == itr->collection_name && assets_itr->schema_name == CONTENT_SCHEMA_NAME
+            && find_asset_range(assets_itr->asset_id, assets_itr->asset_id) == assetranges.end()
+            && !in_asset_ranges(pool_ranges, assets_itr->asset_id)) {
+
+            vector<uint64_t> vec;
+            vec.push_back(assets_itr->asset_id);
+
+            bundles.push_back(vec);
         }
 
-        avatarpacks.emplace(get_self(), [&](auto &_avatarpack) {
-            _avatarpack.pack_asset_id = asset_ids[0];
-            _avatarpack.unboxer = from;
-            _avatarpack.rarity = rarity;
-            _avatarpack.claimable = false;
-        });
+        cursor.last_asset_id = assets_itr->asset_id;
+        scanned++;
+        assets_itr ++;
+    }
 
-    } else {
-        check(memo == "transfer", "Invalid memo");
+    if (bundles.size() > 0) {
+        push_availpacks(itr->pack_id, bundles);
+    }
+
+    gencursor.set(cursor, get_self());
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("loggenpacks"),
+        std::make_tuple(
+            authorized_account,
+            pack_template_id,
+            scanned,
+            (uint64_t) bundles.size(),
+            cursor.last_asset_id,
+            assets_itr == own_assets.end()
+        )
+    ).send();
+}
+
+ACTION packsopener::claimunboxed(
+    uint64_t pack_asset_id
+) {
+
+    auto unboxpack_itr = unboxpacks.require_find(pack_asset_id,
+        "No unboxpack with this pack asset id exists");
+
+    check(has_auth(unboxpack_itr->unboxer) || has_auth(get_self()),
+        "The transaction needs to be authorized either by the unboxer or by the contract itself");
+
+    check(unboxleaves.find(pack_asset_id) == unboxleaves.end(), "Packs with a merkle root are claimed with claimproof");
+
+    action(
+        permission_level{get_self(), name("active")},
+        atomicassets::ATOMICASSETS_ACCOUNT,
+        name("transfer"),
+        std::make_tuple(
+            get_self(),
+            unboxpack_itr->unboxer,
+            unboxpack_itr->assets_ids,
+            "claim unbox pack " + to_string(pack_asset_id)
+        )
+    ).send();
+
+    unbundle_assets(unboxpack_itr->assets_ids);
+
+    decrease_unclaimed(unboxpack_itr->pack_id);
+
+    unboxpacks.erase(unboxpack_itr);
+}
+
+/**
+* Claims an unboxed merkle pack by revealing the contents of its leaf
+* proof holds the sibling hashes from the leaf up to the root, one per tree level
+*/
+ACTION packsopener::claimproof(
+    uint64_t pack_asset_id,
+    vector<uint64_t> assets_ids,
+    vector<checksum256> proof
+) {
+
+    auto unboxpack_itr = unboxpacks.require_find(pack_asset_id,
+        "No unboxpack with this pack asset id exists");
+
+    check(has_auth(unboxpack_itr->unboxer) || has_auth(get_self()),
+        "The transaction needs to be authorized either by the unboxer or by the contract itself");
+
+    auto unboxleaf_itr = unboxleaves.require_find(pack_asset_id,
+        "No leaf was drawn for this pack asset id");
+
+    auto root_itr = packroots.require_find(unboxpack_itr->pack_id,
+        "The pack has no merkle root");
+
+    uint64_t depth = 0;
+    while (((uint64_t) 1 << depth) < root_itr->leaf_count) {
+        depth++;
+    }
+
+    check(proof.size() == depth, "The proof needs to have " + to_string(depth) + " hashes");
+    check(assets_ids.size() > 0, "No assets to claim");
+
+    uint64_t index = unboxleaf_itr->leaf_index;
+    checksum256 node = leaf_hash(unboxpack_itr->pack_id, index, assets_ids);
+
+    for (const checksum256 &sibling : proof) {
+        node = index % 2 == 0 ? node_hash(node, sibling) : node_hash(sibling, node);
+        index /= 2;
+    }
+
+    check(node == root_itr->root, "Invalid proof for the drawn leaf");
+
+    // the assets of a leaf are only known once revealed, so they are checked against the other packs here
+    vector<ASSET_RANGE> pool_ranges = slot_pool_ranges(0);
+    for (uint64_t asset_id : assets_ids) {
+        check(find_asset_range(asset_id, asset_id) == assetranges.end() && !in_asset_ranges(pool_ranges, asset_id),
+            "The asset " + to_string(asset_id) + " is promised by another pack");
+    }
+
+    action(
+        permission_level{get_self(), name("active")},
+        atomicassets::ATOMICASSETS_ACCOUNT,
+        name("transfer"),
+        std::make_tuple(
+            get_self(),
+            unboxpack_itr->unboxer,
+            assets_ids,
+            "claim unbox pack " + to_string(pack_asset_id)
+        )
+    ).send();
+
+    decrease_unclaimed(unboxpack_itr->pack_id);
+
+    unboxleaves.erase(unboxleaf_itr);
+    unboxpacks.erase(unboxpack_itr);
+}
+
+/**
+* Claims up to limit resolved unboxes of an account with a single transfer
+* Entries that are still waiting for randomness are skipped
+*/
+ACTION packsopener::claimall(
+    name unboxer,
+    uint64_t limit
+) {
+
+    check(has_auth(unboxer) || has_auth(get_self()),
+        "The transaction needs to be authorized either by the unboxer or by the contract itself");
+
+    check(limit > 0, "limit needs to be greater than 0");
+
+    auto idx = unboxpacks.get_index<"unboxer"_n>();
+
+    auto itr = idx.lower_bound(unboxer.value);
+
+    uint64_t claimed = 0;
+    vector<uint64_t> assets_ids;
+
+    while (itr != idx.end() && itr->unboxer == unboxer && claimed < limit) {
+        if (itr->assets_ids.empty()) {
+            itr++;
+            continue;
+        }
+
+        assets_ids.insert(assets_ids.end(), itr->assets_ids.begin(), itr->assets_ids.end());
+        claimed++;
+
+        decrease_unclaimed(itr->pack_id);
+
+        itr = idx.erase(itr);
     }
+
+    check(claimed > 0, "No unboxed packs to claim for " + unboxer.to_string());
+
+    action(
+        permission_level{get_self(), name("active")},
+        atomicassets::ATOMICASSETS_ACCOUNT,
+        name("transfer"),
+        std::make_tuple(
+            get_self(),
+            unboxer,
+            assets_ids,
+            "claim " + to_string(claimed) + " unboxed packs"
+        )
+    ).send();
+
+    unbundle_assets(assets_ids);
 }
 
 /**
-* Checks if the account_to_check is in the authorized_accounts vector of the specified collection
+* Moves up to max_rows bundles of a pack from availpacks to compactpacks, keeping their positions
+* Bundles are taken from the packid index, so a call simply continues where the previous one stopped.
+* The call logs through logmigrate how many bundles it moved and whether the pack has none left in availpacks.
+*
+* @required_auth The contract itself
 */
-void packsopener::check_has_collection_auth(
-    name account_to_check,
-    name collection_name
+ACTION packsopener::migratepacks(
+    uint64_t pack_id,
+    uint64_t max_rows
 ) {
-    auto collection_itr = atomicassets::collections.require_find(collection_name.value,
-        "No collection with this name exists");
+    require_auth(get_self());
 
-    check(std::find(
-        collection_itr->authorized_accounts.begin(),
-        collection_itr->authorized_accounts.end(),
-        account_to_check
-        ) != collection_itr->authorized_accounts.end(),
-        "The account " + account_to_check.to_string() + " is not authorized within the collection");
-}
\ No newline at end of file
+    check(max_rows > 0, "max_rows needs to be greater than 0");
+    check(get_packconfig(pack_id).compact, "The pack needs to be configured as compact with setpackcfg first");
+
+    auto availpacks_by_pack_id = availpacks.get_index<name("packid")>();
+    auto itr = availpacks_by_pack_id.lower_bound(pack_id);
+
+    uint64_t migrated = 0;
+    while (itr != availpacks_by_pack_id.end() && itr->pack_id == pack_id && migrated < max_rows) {
+        compactpacks.emplace(get_self(), [&](auto &_compactpack) {
+            _compactpack.id = itr->id;
+            _compactpack.data = encode_bundle(itr->assets_ids);
+        });
+        itr = availpacks_by_pack_id.erase(itr);
+        migrated++;
+    }
+
+    bool done = itr == availpacks_by_pack_id.end() || itr->pack_id != pack_id;
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logmigrate"),
+        std::make_tuple(
+            pack_id,
+            migrated,
+            done
+        )
+    ).send();
+}
+
+/**
+* Read-only page of the unboxes of an account, resolved or still waiting for randomness
+* cursor is the pack asset id to start from, 0 for the first page
+*/
+packsopener::PENDING_PAGE packsopener::getpending(
+    name unboxer,
+    uint64_t cursor,
+    uint64_t limit
+) {
+    check(limit > 0 && limit <= MAX_PAGE_ROWS, "limit needs to be between 1 and " + to_string(MAX_PAGE_ROWS));
+
+    auto idx = unboxpacks.get_index<name("unboxer")>();
+    auto itr = seek_unboxer(unboxpacks, idx, unboxer, cursor);
+
+    PENDING_PAGE page = {};
+
+    while (itr != idx.end() && itr->unboxer == unboxer && page.rows.size() < limit) {
+        bool resolved = !itr->assets_ids.empty() || unboxleaves.find(itr->pack_asset_id) != unboxleaves.end();
+
+        page.rows.push_back({itr->pack_asset_id, itr->pack_id, resolved, itr->assets_ids});
+        itr++;
+    }
+
+    page.more = itr != idx.end() && itr->unboxer == unboxer;
+    page.next_cursor = page.more ? itr->pack_asset_id : 0;
+
+    return page;
+}
+
+/**
+* Read-only page of the avatar packs staked by an account
+* cursor is the pack asset id to start from, 0 for the first page
+*/
+packsopener::AVATAR_PAGE packsopener::getavatars(
+    name unboxer,
+    uint64_t cursor,
+    uint64_t limit
+) {
+    check(limit > 0 && limit <= MAX_PAGE_ROWS, "limit needs to be between 1 and " + to_string(MAX_PAGE_ROWS));
+
+    auto idx = avatarpacks.get_index<name("unboxer")>();
+    auto itr = seek_unboxer(avatarpacks, idx, unboxer, cursor);
+
+    AVATAR_PAGE page = {};
+
+    while (itr != idx.end() && itr->unboxer == unboxer && page.rows.size() < limit) {
+        page.rows.push_back({itr->pack_asset_id, itr->rarity, itr->claimable});
+        itr++;
+    }
+
+    page.more = itr != idx.end() && itr->unboxer == unboxer;
+    page.next_cursor = page.more ? itr->pack_asset_id : 0;
+
+    return page;
+}
+
+/**
+* Read-only page of the bundles left in the inventory of a pack, in position order
+* cursor is the position to start from, 0 for the first page
+* Positions of a pack are a contiguous id range, so availpacks and compactpacks are walked by
+* primary key from the cursor, merging the bundles stored in either table
+*/
+packsopener::INVENTORY_PAGE packsopener::getinventory(
+    uint64_t pack_id,
+    uint64_t cursor,
+    uint64_t limit
+) {
+    check(limit > 0 && limit <= MAX_PAGE_ROWS, "limit needs to be between 1 and " + to_string(MAX_PAGE_ROWS));
+    check(pack_id <= 0xFFFFFFFF && cursor <= 0xFFFFFFFF, "pack_id and cursor need to fit in 32 bits");
+
+    uint64_t last_id = pack_key(pack_id, 0xFFFFFFFF);
+
+    auto availpack_itr = availpacks.lower_bound(pack_key(pack_id, cursor));
+    auto compactpack_itr = compactpacks.lower_bound(pack_key(pack_id, cursor));
+
+    INVENTORY_PAGE page = {};
+
+    while (true) {
+        bool has_availpack = availpack_itr != availpacks.end() && availpack_itr->id <= last_id;
+        bool has_compactpack = compactpack_itr != compactpacks.end() && compactpack_itr->id <= last_id;
+
+        if (!has_availpack && !has_compactpack) {
+            break;
+        }
+
+        bool take_availpack = has_availpack && (!has_compactpack || availpack_itr->id < compactpack_itr->id);
+        uint64_t id = take_availpack ? availpack_itr->id : compactpack_itr->id;
+
+        if (page.rows.size() == limit) {
+            page.more = true;
+            page.next_cursor = id & 0xFFFFFFFF;
+            break;
+        }
+
+        if (take_availpack) {
+            page.rows.push_back({id & 0xFFFFFFFF, availpack_itr->assets_ids});
+            availpack_itr++;
+        } else {
+            page.rows.push_back({id & 0xFFFFFFFF, decode_bundle(compactpack_itr->data)});
+            compactpack_itr++;
+        }
+    }
+
+    return page;
+}
+
+/**
+* Erases at most max_rows rows of a table per call, so that populated tables can be emptied
+* over several transactions. The call logs through logremove how many rows it erased and
+* whether the table is empty.
+* scope is only used by the tables scoped by pack_id (gencursor and stats).
+*
+* availpacks is erased from the last position of the last pack down, so the inventory counters
+* stay consistent between calls. This includes the bundles stored in compactpacks and their assetranges entries.
+* packroots and slotpools also erase the slotchunks and slotsums rows of each pack they remove.
+* unboxpacks also erases the unboxbatch rows and the drawn leaves of the unboxes, and takes them
+* out of the pending and unclaimed stats. packroots is refused while leaves wait for claimproof.
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::removeall(
+    string table,
+    uint64_t scope,
+    uint64_t max_rows
+) {
+
+    require_auth(get_self());
+
+    check(max_rows > 0, "max_rows needs to be greater than 0");
+
+    uint64_t removed = 0;
+    bool done = true;
+
+    if (table == "packs") {
+        removed = erase_rows(packs, max_rows);
+        done = packs.begin() == packs.end();
+    } else if (table == "unboxpacks") {
+        // batches point to unboxpacks rows, so they go first
+        removed = erase_rows(unboxbatch, max_rows);
+
+        auto it = unboxpacks.begin();
+        while (it != unboxpacks.end() && removed < max_rows) {
+            auto unboxleaf_itr = unboxleaves.find(it->pack_asset_id);
+            bool resolved = !it->assets_ids.empty() || unboxleaf_itr != unboxleaves.end();
+
+            if (unboxleaf_itr != unboxleaves.end()) {
+                unboxleaves.erase(unboxleaf_itr);
+            }
+
+            if (resolved) {
+                decrease_unclaimed(it->pack_id);
+            } else {
+                update_stats(it->pack_id, [&](auto &_stats) {
+                    if (_stats.pending > 0) {
+                        _stats.pending--;
+                    }
+                });
+            }
+
+            // the assets of a resolved but unclaimed unbox can be bundled again once its row is gone
+            unbundle_assets(it->assets_ids);
+            it = unboxpacks.erase(it);
+            removed++;
+        }
+        done = unboxpacks.begin() == unboxpacks.end();
+    } else if (table == "availpacks") {
+        auto counts_it = availcounts.end();
+        while (removed < max_rows && counts_it != availcounts.begin()) {
+            counts_it--;
+
+            uint64_t pack_id = counts_it->pack_id;
+            uint64_t count = counts_it->count;
+
+            while (removed < max_rows && count > 0) {
+                count--;
+                unbundle_assets(erase_availpack(pack_key(pack_id, count)));
+                removed++;
+            }
+
+            update_stats(pack_id, [&](auto &_stats) {
+                _stats.available = count;
+            });
+
+            if (count == 0) {
+                gencursor_t(get_self(), pack_id).remove();
+                counts_it = availcounts.erase(counts_it);
+            } else {
+                availcounts.modify(counts_it, get_self(), [&](auto &_counts) {
+                    _counts.count = count;
+                });
+            }
+        }
+
+        // rows not covered by a counter, e.g. written before positions were dense
+        if (removed < max_rows && availcounts.begin() == availcounts.end()) {
+            removed += erase_rows(availpacks, max_rows - removed);
+            removed += erase_rows(compactpacks, max_rows - removed);
+        }
+
+        done = availpacks.begin() == availpacks.end() && compactpacks.begin() == compactpacks.end();
+    } else if (table == "assetranges") {
+        removed = erase_rows(assetranges, max_rows);
+        done = assetranges.begin() == assetranges.end();
+    } else if (table == "unboxbatch") {
+        removed = erase_rows(unboxbatch, max_rows);
+        done = unboxbatch.begin() == unboxbatch.end();
+    } else if (table == "packconfigs") {
+        removed = erase_rows(packconfigs, max_rows);
+        done = packconfigs.begin() == packconfigs.end();
+    } else if (table == "avatartmpls") {
+        removed = erase_rows(avatartmpls, max_rows);
+        done = avatartmpls.begin() == avatartmpls.end();
+    } else if (table == "avatarpacks") {
+        removed = erase_rows(avatarpacks, max_rows);
+        done = avatarpacks.begin() == avatarpacks.end();
+    } else if (table == "shuffles") {
+        removed = erase_rows(shuffles, max_rows);
+        done = shuffles.begin() == shuffles.end();
+    } else if (table == "packrolls") {
+        removed = erase_rows(packrolls, max_rows);
+        done = packrolls.begin() == packrolls.end();
+    } else if (table == "packroots") {
+        check(unboxleaves.begin() == unboxleaves.end(),
+            "Drawn leaves are waiting for claimproof, claim them or remove unboxpacks first");
+        removed = erase_slot_packs(packroots, max_rows);
+        done = packroots.begin() == packroots.end();
+    } else if (table == "slotpools") {
+        removed = erase_slot_packs(slotpools, max_rows);
+        done = slotpools.begin() == slotpools.end();
+    } else if (table == "slotchunks") {
+        removed = erase_rows(slotchunks, max_rows);
+        done = slotchunks.begin() == slotchunks.end();
+    } else if (table == "slotsums") {
+        removed = erase_rows(slotsums, max_rows);
+        done = slotsums.begin() == slotsums.end();
+    } else if (table == "unboxleaves") {
+        removed = erase_rows(unboxleaves, max_rows);
+        done = unboxleaves.begin() == unboxleaves.end();
+    } else if (table == "gencursor") {
+        gencursor_t gencursor = gencursor_t(get_self(), scope);
+        if (gencursor.exists()) {
+            gencursor.remove();
+            removed = 1;
+        }
+    } else if (table == "stats") {
+        stats_t stats = stats_t(get_self(), scope);
+        if (stats.exists()) {
+            stats.remove();
+            removed = 1;
+        }
+    } else {
+        check(false, "Unknown table " + table);
+    }
+
+    action(
+        permission_level{get_self(), name("active")},
+        get_self(),
+        name("logremove"),
+        std::make_tuple(
+            table,
+            scope,
+            removed,
+            done
+        )
+    ).send();
+}
+
+ACTION packsopener::lognewpack(
+    uint64_t pack_id,
+    name collection_name,
+    uint32_t unlock_time
+) {
+    require_auth(get_self());
+}
+
+ACTION packsopener::logremove(
+    string table,
+    uint64_t scope,
+    uint64_t removed,
+    bool done
+) {
+    require_auth(get_self());
+}
+
+ACTION packsopener::loggetrand(
+    uint64_t assoc_id,
+    uint64_t max_value,
+    uint64_t rand_value,
+    vector<uint64_t> vec
+) {
+    require_auth(get_self());
+}
+
+ACTION packsopener::logrolls(
+    uint64_t pack_asset_id,
+    name unboxer,
+    vector<int32_t> template_ids
+) {
+    require_auth(get_self());
+}
+
+ACTION packsopener::logaddpacks(
+    uint64_t pack_id,
+    uint64_t added,
+    uint64_t available
+) {
+    require_auth(get_self());
+}
+
+ACTION packsopener::loggenpacks(
+    name authorized_account,
+    uint64_t pack_template_id,
+    uint64_t scanned,
+    uint64_t added,
+    uint64_t last_asset_id,
+    bool done
+) {
+    require_auth(get_self());
+}
+
+ACTION packsopener::logmigrate(
+    uint64_t pack_id,
+    uint64_t migrated,
+    bool done
+) {
+    require_auth(get_self());
+}
+
+/**
+* Requests new randomness for a given assoc_id
+* This is supposed to be used in the rare case that the RNG oracle kills a job for a pack unboxing
+* due to issues with the finisher script.
+* For packs unboxed together the assoc id is the asset id of the first pack of the transfer.
+*
+* @required_auth The contract itself
+*/
+ACTION packsopener::retryrand(
+    uint64_t pack_asset_id
+) {
+    require_auth(get_self());
+
+    auto pack_itr = unboxpacks.require_find(pack_asset_id,
+        "No open unboxpacks entry with the specified pack asset id exists");
+    
+    check(pack_itr->assets_ids.empty() && unboxleaves.find(pack_asset_id) == unboxleaves.end(),
+        "The specified pack asset id already has results");
+
+    //Get signing value from transaction id
+    //As this is only used as the signing value for the randomness oracle, it does not matter that this
+    //signing value is not truly random
+
+    auto size = transaction_size();
+    char buf[size];
+
+    auto read = read_transaction(buf, size);
+    check(size == read, "read_transaction() has failed.");
+
+    checksum256 tx_id = eosio::sha256(buf, read);
+
+    uint64_t signing_value;
+
+    memcpy(&signing_value, tx_id.data(), sizeof(signing_value));
+
+    action(
+        permission_level{get_self(), name("active")},
+        name("orng.wax"),
+        name("requestrand"),
+        std::make_tuple(
+            pack_asset_id, //used as assoc id
+            signing_value,
+            get_self()
+        )
+    ).send();
+}
+
+/**
+* Funcion from atomicpacks contract
+*
+* This function is called when AtomicAssets assets are transferred to the pack contract
+
+* This is used to unbox packs, by transferring up to MAX_UNBOX_PACKS packs to the pack contract
+* A single random value is requested from the rng oracle for all of them, the packs are burned when it arrives
+*/
+void packsopener::receive_asset_transfer(
+    name from,
+    name to,
+    vector <uint64_t> asset_ids,
+    string memo
+) {
+    if (to != get_self()) {
+        return;
+    }
+
+    if (memo == "unbox") {
+
+        check(asset_ids.size() <= MAX_UNBOX_PACKS,
+            "Only " + to_string(MAX_UNBOX_PACKS) + " packs can be opened at a time");
+
+        atomicassets::assets_t own_assets = atomicassets::get_assets(get_self());
+
+        auto packs_by_template_id = packs.get_index<name("templateid")>();
+        auto pack_itr = packs_by_template_id.end();
+
+        // unboxes per pack, the stats of each pack are written once
+        map<uint64_t, uint64_t> pending_by_pack_id;
+
+        for (uint64_t asset_id : asset_ids) {
+
+            auto asset_itr = own_assets.require_find(asset_id,
+                "The transferred asset is not owned by the contract");
+
+            check(asset_itr->template_id != -1, "The transferred asset does not belong to a template");
+
+            // packs of one transfer usually share the template
+            if (pack_itr == packs_by_template_id.end() || pack_itr->pack_template_id != asset_itr->template_id) {
+                pack_itr = packs_by_template_id.require_find(asset_itr->template_id,
+                    "The transferred asset's template does not belong to any pack");
+
+                check(pack_itr->unlock_time <= current_time_point().sec_since_epoch(), "The pack has not unlocked yet");
+            }
+
+            //It is not necessary to check the necessary RAM because the content of the packs is pre-mined
+
+            unboxpacks.emplace(get_self(), [&](auto &_unboxpack) {
+                _unboxpack.pack_asset_id = asset_id;
+                _unboxpack.pack_id = pack_itr->pack_id;
+                _unboxpack.unboxer = from;
+            });
+
+            pending_by_pack_id[pack_itr->pack_id]++;
+        }
+
+        for (const auto &pending : pending_by_pack_id) {
+            update_stats(pending.first, [&](auto &_stats) {
+                _stats.pending += pending.second;
+            });
+        }
+
+        if (asset_ids.size() > 1) {
+            unboxbatch.emplace(get_self(), [&](auto &_batch) {
+                _batch.assoc_id = asset_ids[0];
+                _batch.pack_asset_ids = asset_ids;
+            });
+        }
+
+        //Get signing value from transaction id
+        //As this is only used as the signing value for the randomness oracle, it does not matter that this
+        //signing value is not truly random
+
+        auto size = transaction_size();
+        char buf[size];
+
+        auto read = read_transaction(buf, size);
+        check(size == read, "read_transaction() has failed.");
+
+        checksum256 tx_id = eosio::sha256(buf, read);
+
+        uint64_t signing_value;
+
+        memcpy(&signing_value, tx_id.data(), sizeof(signing_value));
+
+        action(
+            permission_level{get_self(), name("active")},
+            name("orng.wax"),
+            name("requestrand"),
+            std::make_tuple(
+                asset_ids[0], //used as assoc id
+                signing_value,
+                get_self()
+            )
+        ).send();
+    } else if (memo == "unbox avatar") {
+
+        check(asset_ids.size() == 1, "Only one pack can be opened at a time.");
+
+        auto idx = avatarpacks.get_index<"unboxer"_n>();
+        
+        auto itr = idx.find(from.value); 
+
+        check(itr == idx.end(), "YOU CAN ONLY STAKE ONE AMNIO-TANK AT ONCE.");
+
+        atomicassets::assets_t own_assets = atomicassets::get_assets(get_self());
+        auto asset_itr = own_assets.find(asset_ids[0]);
+
+        check(asset_itr->collection_name == COLLECTION_NAME, "NFT doesn't correspond to clashdomenft");
+        check(asset_itr->schema_name == CREATE_AVATAR_SCHEMA_NAME, "NFT doesn't correspond to schema packs");
+
+        string rarity = get_avatar_rarity(asset_itr->template_id);
+
+        avatarpacks.emplace(get_self(), [&](auto &_avatarpack) {
+            _avatarpack.pack_asset_id = asset_ids[0];
+            _avatarpack.unboxer = from;
+            _avatarpack.rarity = rarity;
+            _avatarpack.claimable = false;
+        });
+
+    } else {
+        check(memo == "transfer", "Invalid memo");
+    }
+}
+
+packsopener::random_stream::random_stream(
+    const checksum256 &random_value
+) {
+    seed = random_value.extract_as_byte_array();
+    block = seed;
+}
+
+/**
+* Returns the next 64 bit value, read big endian from the current 32 byte block
+*/
+uint64_t packsopener::random_stream::next() {
+    if (offset == block.size()) {
+        block_number++;
+
+        uint8_t buf[40];
+        memcpy(buf, seed.data(), seed.size());
+        memcpy(buf + seed.size(), &block_number, sizeof(block_number));
+
+        block = eosio::sha256((const char *) buf, sizeof(buf)).extract_as_byte_array();
+        offset = 0;
+    }
+
+    uint64_t random_int = 0;
+    for (int i = 0; i < 8; i++) {
+        random_int <<= 8;
+        random_int |= (uint64_t)block[offset + i];
+    }
+    offset += 8;
+
+    return random_int;
+}
+
+/**
+* Checks if the account_to_check is in the authorized_accounts vector of the specified collection
+*/
+void packsopener::check_has_collection_auth(
+    name account_to_check,
+    name collection_name
+) {
+    auto collection_itr = atomicassets::collections.require_find(collection_name.value,
+        "No collection with this name exists");
+
+    check(std::find(
+        collection_itr->authorized_accounts.begin(),
+        collection_itr->authorized_accounts.end(),
+        account_to_check
+        ) != collection_itr->authorized_accounts.end(),
+        "The account " + account_to_check.to_string() + " is not authorized within the collection");
+}
+
+/**
+* Returns the unbox options of a pack, or the defaults when none were set
+*/
+packsopener::packconfigs_s packsopener::get_packconfig(
+    uint64_t pack_id
+) {
+    auto config_itr = packconfigs.find(pack_id);
+
+    if (config_itr == packconfigs.end()) {
+        return {pack_id, false, false};
+    }
+
+    return *config_itr;
+}
+
+/**
+* Reads the stats singleton of a pack, applies updater to it and writes it back
+*/
+template<typename F>
+void packsopener::update_stats(
+    uint64_t pack_id,
+    F &&updater
+) {
+    stats_t stats = stats_t(get_self(), pack_id);
+    stats_s row = stats.get_or_default();
+
+    updater(row);
+
+    stats.set(row, get_self());
+}
+
+/**
+* Counts one resolved unbox of a pack as claimed
+* Unboxes resolved before the stats were kept are not counted, so the counter never goes below zero
+*/
+void packsopener::decrease_unclaimed(
+    uint64_t pack_id
+) {
+    update_stats(pack_id, [&](auto &_stats) {
+        if (_stats.unclaimed > 0) {
+            _stats.unclaimed--;
+        }
+    });
+}
+
+/**
+* Returns the rarity of an avatar template, from the avatartmpls row of the template
+* The schema and the template data are only read when the rarity comes from an attribute,
+* and then only that attribute is decoded
+* Templates without a row fall back to the original three avatar templates
+*/
+string packsopener::get_avatar_rarity(
+    int32_t template_id
+) {
+    auto avatartmpl_itr = avatartmpls.find((uint64_t) template_id);
+
+    if (avatartmpl_itr == avatartmpls.end()) {
+        for (const AVATAR_RARITY &default_rarity : DEFAULT_AVATAR_RARITIES) {
+            if (default_rarity.template_id == template_id) {
+                return default_rarity.rarity;
+            }
+        }
+
+        check(false, "NFT doesn't correspond to template ids.");
+    }
+
+    if (avatartmpl_itr->rarity_attribute.empty()) {
+        return avatartmpl_itr->rarity;
+    }
+
+    atomicassets::schemas_t collection_schemas = atomicassets::get_schemas(COLLECTION_NAME);
+    auto schema_itr = collection_schemas.require_find(CREATE_AVATAR_SCHEMA_NAME.value,
+        "No avatar schema exists");
+
+    atomicassets::templates_t collection_templates = atomicassets::get_templates(COLLECTION_NAME);
+    auto template_itr = collection_templates.require_find((uint64_t) template_id,
+        "No template with this id exists");
+
+    std::optional<string> rarity = atomicdata::get_as<string>(template_itr->immutable_serialized_data,
+        schema_itr->format, avatartmpl_itr->rarity_attribute);
+
+    check(rarity.has_value(), "The template has no attribute " + avatartmpl_itr->rarity_attribute);
+
+    return *rarity;
+}
+
+/**
+* Positions an unboxer index at the row of the given pack asset id, or at the first row of the
+* unboxer after it when that row is gone. cursor 0 starts at the first row of the unboxer
+*/
+template<typename T, typename I>
+typename I::const_iterator packsopener::seek_unboxer(
+    T &table,
+    I &idx,
+    name unboxer,
+    uint64_t cursor
+) {
+    if (cursor != 0) {
+        auto cursor_itr = table.find(cursor);
+        if (cursor_itr != table.end() && cursor_itr->unboxer == unboxer) {
+            return idx.iterator_to(*cursor_itr);
+        }
+    }
+
+    auto itr = idx.lower_bound(unboxer.value);
+    while (itr != idx.end() && itr->unboxer == unboxer && itr->pack_asset_id < cursor) {
+        itr++;
+    }
+
+    return itr;
+}
+
+template<typename T>
+uint64_t packsopener::erase_rows(
+    T &table,
+    uint64_t max_rows
+) {
+    uint64_t removed = 0;
+
+    auto it = table.begin();
+    while (it != table.end() && removed < max_rows) {
+        it = table.erase(it);
+        removed++;
+    }
+
+    return removed;
+}
+
+/**
+* Erases the rows of a table of packs whose unboxes are tracked in slotchunks and slotsums
+* The bitmap and fenwick rows of a pack are erased before the pack row, so a pack set up again later
+* starts from empty slots. A pack row is only erased once all its slot rows fit within max_rows
+*/
+template<typename T>
+uint64_t packsopener::erase_slot_packs(
+    T &table,
+    uint64_t max_rows
+) {
+    uint64_t removed = 0;
+
+    auto it = table.begin();
+    while (it != table.end() && removed < max_rows) {
+        removed += erase_slot_rows(it->pack_id, max_rows - removed);
+
+        if (removed < max_rows) {
+            it = table.erase(it);
+            removed++;
+        }
+    }
+
+    return removed;
+}
+
+/**
+* Erases up to max_rows slotchunks and slotsums rows of a pack
+*/
+uint64_t packsopener::erase_slot_rows(
+    uint64_t pack_id,
+    uint64_t max_rows
+) {
+    uint64_t removed = 0;
+
+    auto chunk_itr = slotchunks.lower_bound(pack_key(pack_id, 0));
+    while (chunk_itr != slotchunks.end() && chunk_itr->id >> 32 == pack_id && removed < max_rows) {
+        chunk_itr = slotchunks.erase(chunk_itr);
+        removed++;
+    }
+
+    auto sum_itr = slotsums.lower_bound(pack_key(pack_id, 0));
+    while (sum_itr != slotsums.end() && sum_itr->id >> 32 == pack_id && removed < max_rows) {
+        sum_itr = slotsums.erase(sum_itr);
+        removed++;
+    }
+
+    return removed;
+}
+
+bool packsopener::has_slot_rows(
+    uint64_t pack_id
+) {
+    auto chunk_itr = slotchunks.lower_bound(pack_key(pack_id, 0));
+    auto sum_itr = slotsums.lower_bound(pack_key(pack_id, 0));
+
+    return (chunk_itr != slotchunks.end() && chunk_itr->id >> 32 == pack_id)
+        || (sum_itr != slotsums.end() && sum_itr->id >> 32 == pack_id);
+}
+
+/**
+* Checks that a pack is not unboxed from any other source than mode
+* A pack is unboxed from its bundles, its rolls, its merkle root or its slot pool, never from two of them
+*/
+void packsopener::check_pack_mode_free(
+    uint64_t pack_id,
+    PACK_MODE mode
+) {
+    if (mode != MODE_BUNDLES) {
+        auto counts_itr = availcounts.find(pack_id);
+        check(counts_itr == availcounts.end() || counts_itr->count == 0, "The pack still has bundles in availpacks");
+    }
+    if (mode != MODE_ROLLS) {
+        check(!has_rolls(pack_id), "The pack has rolls");
+    }
+    if (mode != MODE_ROOT) {
+        check(packroots.find(pack_id) == packroots.end(), "The pack has a merkle root");
+    }
+    if (mode != MODE_POOL) {
+        check(slotpools.find(pack_id) == slotpools.end(), "The pack is a slot pool");
+    }
+}
+
+bool packsopener::has_rolls(
+    uint64_t pack_id
+) {
+    auto roll_itr = packrolls.lower_bound(pack_key(pack_id, 0));
+    return roll_itr != packrolls.end() && roll_itr->id >> 32 == pack_id;
+}
+
+/**
+* Key of the rows of a pack in the tables keyed by pack and index:
+* availpacks and compactpacks positions, packrolls, slotchunks and slotsums
+*/
+uint64_t packsopener::pack_key(
+    uint64_t pack_id,
+    uint64_t index
+) {
+    return (pack_id << 32) | index;
+}
+
+/**
+* Encodes the assets of a bundle for compactpacks
+* Asset ids of a bundle are usually close to each other, so after the first one most take one or two bytes
+*/
+vector<uint8_t> packsopener::encode_bundle(
+    const vector<uint64_t> &assets_ids
+) {
+    vector<uint8_t> data;
+    uint64_t previous = 0;
+
+    for (uint64_t asset_id : assets_ids) {
+        vector<uint8_t> bytes = data.empty()
+            ? atomicdata::toVarintBytes(asset_id)
+            : atomicdata::toVarintBytes(atomicdata::zigzagEncode((int64_t) (asset_id - previous)));
+        data.insert(data.end(), bytes.begin(), bytes.end());
+        previous = asset_id;
+    }
+
+    return data;
+}
+
+vector<uint64_t> packsopener::decode_bundle(
+    const vector<uint8_t> &data
+) {
+    vector<uint64_t> assets_ids;
+
+    atomicdata::byte_reader reader(data.data(), data.size());
+    while (!reader.empty()) {
+        uint64_t value = reader.read_varint();
+        assets_ids.push_back(assets_ids.empty()
+            ? value
+            : assets_ids.back() + (uint64_t) atomicdata::zigzagDecode(value));
+    }
+
+    return assets_ids;
+}
+
+/**
+* Returns the assets of the bundle with the given id, from availpacks or compactpacks
+*/
+vector<uint64_t> packsopener::read_availpack(
+    uint64_t id
+) {
+    auto availpack_itr = availpacks.find(id);
+    if (availpack_itr != availpacks.end()) {
+        return availpack_itr->assets_ids;
+    }
+
+    auto compactpack_itr = compactpacks.require_find(id, "No available pack at this position");
+    return decode_bundle(compactpack_itr->data);
+}
+
+/**
+* Replaces the assets of the bundle with the given id, in the table that already stores it
+*/
+void packsopener::write_availpack(
+    uint64_t id,
+    const vector<uint64_t> &assets_ids
+) {
+    auto availpack_itr = availpacks.find(id);
+    if (availpack_itr != availpacks.end()) {
+        availpacks.modify(availpack_itr, get_self(), [&](auto &_availpack) {
+            _availpack.assets_ids = assets_ids;
+        });
+        return;
+    }
+
+    auto compactpack_itr = compactpacks.require_find(id, "No available pack at this position");
+    compactpacks.modify(compactpack_itr, get_self(), [&](auto &_compactpack) {
+        _compactpack.data = encode_bundle(assets_ids);
+    });
+}
+
+/**
+* Erases the bundle with the given id from availpacks or compactpacks and returns its assets
+*/
+vector<uint64_t> packsopener::erase_availpack(
+    uint64_t id
+) {
+    vector<uint64_t> assets_ids;
+
+    auto availpack_itr = availpacks.find(id);
+    if (availpack_itr != availpacks.end()) {
+        assets_ids = availpack_itr->assets_ids;
+        availpacks.erase(availpack_itr);
+        return assets_ids;
+    }
+
+    auto compactpack_itr = compactpacks.require_find(id, "No available pack at this position");
+    assets_ids = decode_bundle(compactpack_itr->data);
+    compactpacks.erase(compactpack_itr);
+    return assets_ids;
+}
+
+/**
+* Returns a range of assetranges that overlaps [first_asset_id, last_asset_id], or end() when there is none
+* Ranges are disjoint, so only the last range starting at or before last_asset_id can overlap
+*/
+packsopener::assetranges_t::const_iterator packsopener::find_asset_range(
+    uint64_t first_asset_id,
+    uint64_t last_asset_id
+) {
+    auto range_itr = assetranges.upper_bound(last_asset_id);
+    if (range_itr == assetranges.begin()) {
+        return assetranges.end();
+    }
+
+    range_itr--;
+    return range_itr->last_asset_id >= first_asset_id ? range_itr : assetranges.end();
+}
+
+/**
+* Adds an asset to the reverse index, merging it with the ranges that end right before or start right after it
+*/
+void packsopener::bundle_asset(
+    uint64_t asset_id
+) {
+    auto next_itr = assetranges.upper_bound(asset_id);
+    auto previous_itr = next_itr;
+
+    bool merge_previous = false;
+    if (previous_itr != assetranges.begin()) {
+        previous_itr--;
+        check(previous_itr->last_asset_id < asset_id,
+            "The asset " + to_string(asset_id) + " is already in an available pack");
+        merge_previous = previous_itr->last_asset_id == asset_id - 1;
+    }
+
+    bool merge_next = next_itr != assetranges.end() && next_itr->first_asset_id == asset_id + 1;
+
+    if (merge_previous) {
+        uint64_t last_asset_id = merge_next ? next_itr->last_asset_id : asset_id;
+        if (merge_next) {
+            assetranges.erase(next_itr);
+        }
+        assetranges.modify(previous_itr, get_self(), [&](auto &_range) {
+            _range.last_asset_id = last_asset_id;
+        });
+        return;
+    }
+
+    uint64_t last_asset_id = asset_id;
+    if (merge_next) {
+        // the range starts earlier now, and its start is the primary key
+        last_asset_id = next_itr->last_asset_id;
+        assetranges.erase(next_itr);
+    }
+
+    assetranges.emplace(get_self(), [&](auto &_range) {
+        _range.first_asset_id = asset_id;
+        _range.last_asset_id = last_asset_id;
+    });
+}
+
+/**
+* Removes assets that left the contract, or whose bundle or unbox was removed, from the reverse index
+* Removing an asset from the middle of a range splits it in two
+*/
+void packsopener::unbundle_assets(
+    const vector<uint64_t> &assets_ids
+) {
+    for (uint64_t asset_id : assets_ids) {
+        auto range_itr = find_asset_range(asset_id, asset_id);
+        if (range_itr == assetranges.end()) {
+            continue;
+        }
+
+        uint64_t first_asset_id = range_itr->first_asset_id;
+        uint64_t last_asset_id = range_itr->last_asset_id;
+
+        if (first_asset_id == asset_id) {
+            assetranges.erase(range_itr);
+        } else {
+            assetranges.modify(range_itr, get_self(), [&](auto &_range) {
+                _range.last_asset_id = asset_id - 1;
+            });
+        }
+
+        if (last_asset_id != asset_id) {
+            assetranges.emplace(get_self(), [&](auto &_range) {
+                _range.first_asset_id = asset_id + 1;
+                _range.last_asset_id = last_asset_id;
+            });
+        }
+    }
+}
+
+/**
+* Returns the asset ranges reserved by the slot pools, except the one of skipped_pack_id, sorted by first asset id
+* There is at most one pool per pack, so all of them are read
+*/
+vector<packsopener::ASSET_RANGE> packsopener::slot_pool_ranges(
+    uint64_t skipped_pack_id
+) {
+    vector<ASSET_RANGE> ranges;
+
+    for (const auto &pool : slotpools) {
+        if (pool.pack_id != skipped_pack_id) {
+            ranges.push_back({pool.first_asset_id, pool.first_asset_id + pool.slot_count * pool.assets_per_slot - 1});
+        }
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const ASSET_RANGE &a, const ASSET_RANGE &b) {
+        return a.first_asset_id < b.first_asset_id;
+    });
+
+    return ranges;
+}
+
+bool packsopener::in_asset_ranges(
+    const vector<ASSET_RANGE> &ranges,
+    uint64_t asset_id
+) {
+    auto itr = std::upper_bound(ranges.begin(), ranges.end(), asset_id, [](uint64_t id, const ASSET_RANGE &range) {
+        return id < range.first_asset_id;
+    });
+
+    return itr != ranges.begin() && (itr - 1)->last_asset_id >= asset_id;
+}
+
+/**
+* Returns the shuffle value of a position: the first 8 bytes of sha256(seed, position), read big endian,
+* with the position as 8 little endian bytes
+*/
+uint64_t packsopener::shuffle_value(
+    const checksum256 &seed,
+    uint64_t position
+) {
+    uint8_t buf[40];
+
+    auto seed_bytes = seed.extract_as_byte_array();
+    memcpy(buf, seed_bytes.data(), 32);
+    for (int i = 0; i < 8; i++) {
+        buf[32 + i] = (uint8_t) (position >> (8 * i));
+    }
+
+    auto hash = eosio::sha256((const char *) buf, sizeof(buf)).extract_as_byte_array();
+
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | hash[i];
+    }
+    return value;
+}
+
+/**
+* Appends bundles at the end of the dense inventory of a pack
+* Bundles of pre-shuffled packs are inserted at a position given by the revealed seed instead
+* Fails for packs unboxed from rolls, a merkle root or a slot pool, for empty bundles and when one
+* of the assets is already in an available bundle of any pack
+* The counter row is read and written once, however many bundles are added
+*
+* @return the number of bundles available for the pack afterwards
+*/
+uint64_t packsopener::push_availpacks(
+    uint64_t pack_id,
+    const vector<vector<uint64_t>> &bundles
+) {
+    auto counts_itr = availcounts.find(pack_id);
+
+    uint64_t position = counts_itr == availcounts.end() ? 0 : counts_itr->count;
+    uint64_t count = position + bundles.size();
+
+    check(pack_id <= 0xFFFFFFFF && count <= 0x100000000, "Pack inventory is full");
+
+    // bundles of packs unboxed from another source would never be handed out
+    check_pack_mode_free(pack_id, MODE_BUNDLES);
+
+    bool compact = get_packconfig(pack_id).compact;
+
+    auto shuffle_itr = shuffles.find(pack_id);
+    check(shuffle_itr == shuffles.end() || shuffle_itr->revealed,
+        "The shuffle seed of the pack needs to be revealed before loading bundles");
+
+    vector<ASSET_RANGE> pool_ranges = slot_pool_ranges(0);
+
+    for (const auto &assets_ids : bundles) {
+        check(!assets_ids.empty(), "A bundle needs to have at least one asset");
+
+        for (uint64_t asset_id : assets_ids) {
+            check(!in_asset_ranges(pool_ranges, asset_id),
+                "The asset " + to_string(asset_id) + " is reserved by a slot pool");
+
+            bundle_asset(asset_id);
+        }
+    }
+
+    if (counts_itr == availcounts.end()) {
+        availcounts.emplace(get_self(), [&](auto &_counts) {
+            _counts.pack_id = pack_id;
+            _counts.count = count;
+        });
+    } else {
+        availcounts.modify(counts_itr, get_self(), [&](auto &_counts) {
+            _counts.count = count;
+        });
+    }
+
+    auto emplace_bundle = [&](uint64_t bundle_position, const vector<uint64_t> &assets_ids) {
+        if (compact) {
+            compactpacks.emplace(get_self(), [&](auto &_compactpack) {
+                _compactpack.id = pack_key(pack_id, bundle_position);
+                _compactpack.data = encode_bundle(assets_ids);
+            });
+        } else {
+            availpacks.emplace(get_self(), [&](auto &_availpack) {
+                _availpack.id = pack_key(pack_id, bundle_position);
+                _availpack.pack_id = pack_id;
+                _availpack.assets_ids = assets_ids;
+            });
+        }
+    };
+
+    for (const auto &assets_ids : bundles) {
+        // inside-out Fisher-Yates: the new bundle goes to a seeded position and the bundle there moves to the end
+        uint64_t swap_position = shuffle_itr == shuffles.end()
+            ? position
+            : shuffle_value(shuffle_itr->seed, position) % (position + 1);
+
+        if (swap_position == position) {
+            emplace_bundle(position, assets_ids);
+        } else {
+            emplace_bundle(position, read_availpack(pack_key(pack_id, swap_position)));
+            write_availpack(pack_key(pack_id, swap_position), assets_ids);
+        }
+        position++;
+    }
+
+    update_stats(pack_id, [&](auto &_stats) {
+        _stats.available = count;
+    });
+
+    return count;
+}
+
+/**
+* Removes the bundle at the given position from the inventory of a pack and returns its assets
+* The last bundle of the pack is moved into the freed position, so the inventory stays dense
+* The assets stay in assetranges until they leave the contract
+*/
+vector<uint64_t> packsopener::take_availpack(
+    availcounts_t::const_iterator counts_itr,
+    uint64_t position
+) {
+    uint64_t pack_id = counts_itr->pack_id;
+    uint64_t last_position = counts_itr->count - 1;
+
+    vector<uint64_t> assets_ids;
+
+    if (position != last_position) {
+        assets_ids = read_availpack(pack_key(pack_id, position));
+        write_availpack(pack_key(pack_id, position), erase_availpack(pack_key(pack_id, last_position)));
+    } else {
+        assets_ids = erase_availpack(pack_key(pack_id, position));
+    }
+
+    availcounts.modify(counts_itr, get_self(), [&](auto &_counts) {
+        _counts.count--;
+    });
+
+    return assets_ids;
+}
+
+/**
+* Draws every roll of a pack and mints the outcomes to the unboxer
+* Each roll uses two random values: one picks the column of the alias table, the other one
+* decides between the outcome of the column and its alias
+*
+* @return the template id drawn by each roll, -1 for the rolls that gave nothing
+*/
+vector<int32_t> packsopener::roll_pack(
+    uint64_t pack_id,
+    name unboxer,
+    random_stream &random
+) {
+    name collection_name = packs.get(pack_id, "No pack with this id exists").collection_name;
+
+    vector<int32_t> template_ids;
+
+    for (auto roll_itr = packrolls.lower_bound(pack_key(pack_id, 0));
+        roll_itr != packrolls.end() && roll_itr->id >> 32 == pack_id;
+        roll_itr++) {
+
+        uint64_t column = random.next() % roll_itr->outcomes.size();
+        uint64_t outcome = random.next() % roll_itr->total_odds < roll_itr->thresholds[column]
+            ? column
+            : roll_itr->aliases[column];
+
+        int32_t template_id = roll_itr->outcomes[outcome].template_id;
+        template_ids.push_back(template_id);
+
+        if (template_id == -1) {
+            continue;
+        }
+
+        action(
+            permission_level{get_self(), name("active")},
+            atomicassets::ATOMICASSETS_ACCOUNT,
+            name("mintasset"),
+            std::make_tuple(
+                get_self(),
+                collection_name,
+                roll_itr->schema_names[outcome],
+                template_id,
+                unboxer,
+                atomicdata::ATTRIBUTE_MAP{},
+                atomicdata::ATTRIBUTE_MAP{},
+                vector<asset>{}
+            )
+        ).send();
+    }
+
+    return template_ids;
+}
+
+/**
+* Marks the unused slot of rank random_int % (slot_count - used_count) as used and returns its index
+* The fenwick tree in slotsums gives the chunk holding that slot in log2(chunks) row reads,
+* the slot is then selected inside the bitmap of that one chunk
+*/
+uint64_t packsopener::take_slot(
+    uint64_t pack_id,
+    uint64_t slot_count,
+    uint64_t used_count,
+    uint64_t random_int
+) {
+    uint64_t chunk_count = (slot_count + SLOTS_PER_CHUNK - 1) / SLOTS_PER_CHUNK;
+    uint64_t rank = random_int % (slot_count - used_count);
+
+    // chunk ends as the number of chunks before the one holding the slot, i.e. its index
+    uint64_t chunk = 0;
+    uint64_t step = 1;
+    while (step * 2 <= chunk_count) {
+        step *= 2;
+    }
+
+    for (; step > 0; step /= 2) {
+        uint64_t node = chunk + step;
+        if (node > chunk_count) {
+            continue;
+        }
+
+        auto sum_itr = slotsums.find(pack_key(pack_id, node));
+        uint64_t used = sum_itr == slotsums.end() ? 0 : sum_itr->used;
+        uint64_t free = std::min(node * SLOTS_PER_CHUNK, slot_count) - chunk * SLOTS_PER_CHUNK - used;
+
+        if (free <= rank) {
+            rank -= free;
+            chunk = node;
+        }
+    }
+
+    uint64_t chunk_id = pack_key(pack_id, chunk);
+    auto chunk_itr = slotchunks.find(chunk_id);
+
+    vector<uint64_t> words = chunk_itr == slotchunks.end()
+        ? vector<uint64_t>(SLOTS_PER_CHUNK / 64, 0)
+        : chunk_itr->words;
+
+    // slots past slot_count are at the end of the last chunk, so they are never reached by the rank
+    uint64_t word = 0;
+    while (rank >= (uint64_t) __builtin_popcountll(~words[word])) {
+        rank -= __builtin_popcountll(~words[word]);
+        word++;
+        check(word < words.size(), "Slot bitmap out of sync");
+    }
+
+    uint64_t free_bits = ~words[word];
+    for (; rank > 0; rank--) {
+        free_bits &= free_bits - 1;
+    }
+    uint64_t bit = __builtin_ctzll(free_bits);
+
+    words[word] |= (uint64_t) 1 << bit;
+
+    if (chunk_itr == slotchunks.end()) {
+        slotchunks.emplace(get_self(), [&](auto &_chunk) {
+            _chunk.id = chunk_id;
+            _chunk.words = words;
+        });
+    } else {
+        slotchunks.modify(chunk_itr, get_self(), [&](auto &_chunk) {
+            _chunk.words = words;
+        });
+    }
+
+    for (uint64_t node = chunk + 1; node <= chunk_count; node += node & (~node + 1)) {
+        auto sum_itr = slotsums.find(pack_key(pack_id, node));
+
+        if (sum_itr == slotsums.end()) {
+            slotsums.emplace(get_self(), [&](auto &_sum) {
+                _sum.id = pack_key(pack_id, node);
+                _sum.used = 1;
+            });
+        } else {
+            slotsums.modify(sum_itr, get_self(), [&](auto &_sum) {
+                _sum.used++;
+            });
+        }
+    }
+
+    return chunk * SLOTS_PER_CHUNK + word * 64 + bit;
+}
+
+checksum256 packsopener::leaf_hash(
+    uint64_t pack_id,
+    uint64_t leaf_index,
+    const vector<uint64_t> &assets_ids
+) {
+    vector<uint8_t> buf(1 + 8 * (2 + assets_ids.size()));
+    buf[0] = 0;
+
+    uint64_t offset = 1;
+    auto write = [&](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            buf[offset++] = (uint8_t) (value >> (8 * i));
+        }
+    };
+
+    write(pack_id);
+    write(leaf_index);
+    for (uint64_t asset_id : assets_ids) {
+        write(asset_id);
+    }
+
+    return eosio::sha256((const char *) buf.data(), buf.size());
+}
+
+checksum256 packsopener::node_hash(
+    const checksum256 &left,
+    const checksum256 &right
+) {
+    uint8_t buf[65];
+    buf[0] = 1;
+
+    auto left_bytes = left.extract_as_byte_array();
+    auto right_bytes = right.extract_as_byte_array();
+    memcpy(buf + 1, left_bytes.data(), 32);
+    memcpy(buf + 33, right_bytes.data(), 32);
+
+    return eosio::sha256((const char *) buf, sizeof(buf));
+}
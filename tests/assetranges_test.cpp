@@ -0,0 +1,72 @@
+/**
+ * An asset is promised by at most one pack: genpacks skips the assets of slot pools and of unclaimed unboxes,
+ * and the reverse index keeps them until they are claimed
+ */
+
+#include "host_test.hpp"
+
+using namespace host_test;
+
+static const int32_t POOL_TEMPLATE_ID = 100;
+static const int32_t BUNDLE_TEMPLATE_ID = 200;
+static const uint64_t PACK_FIRST_ID = 1ULL << 40;
+static const uint64_t POOL_SLOTS = 2500;
+static const uint64_t CONTENT_ASSETS = 3000;
+
+//loggenpacks arguments: authorized_account, pack_template_id, scanned, added, last_asset_id, done
+typedef std::tuple <name, uint64_t, uint64_t, uint64_t, uint64_t, bool> loggenpacks_args;
+
+static uint64_t genpacks_added(packsopener &opener) {
+    host::get_chain().actions.clear();
+    opener.genpacks(SELF, BUNDLE_TEMPLATE_ID, CONTENT_ASSETS);
+    return std::get <3>(last_action <loggenpacks_args>(name("loggenpacks")));
+}
+
+int main() {
+    packsopener opener = setup();
+    auto &chain = host::get_chain();
+
+    chain.set_auth({SELF});
+    opener.createpack(SELF, COLLECTION, 0, POOL_TEMPLATE_ID, "");
+    opener.createpack(SELF, COLLECTION, 0, BUNDLE_TEMPLATE_ID, "");
+
+    for (uint64_t asset_id = 1; asset_id <= CONTENT_ASSETS; asset_id++) {
+        add_asset(asset_id, name("poolhalls"), -1);
+    }
+
+    //The pool reserves assets 1 to 2500, genpacks only bundles the 500 after them
+    opener.setslotpool(1, 1, POOL_SLOTS, 1);
+    EXPECT(genpacks_added(opener) == CONTENT_ASSETS - POOL_SLOTS);
+
+    EXPECT_FAIL(opener.addpack(2, {5}));
+    EXPECT_FAIL(opener.addpack(2, {2600}));
+    EXPECT_FAIL(opener.setslotpool(1, 2990, 20, 1));
+
+    //A reset of the cursor and of the inventory does not bundle the unboxed asset again
+    add_asset(PACK_FIRST_ID, name("packs"), BUNDLE_TEMPLATE_ID);
+    unbox(opener, name("bob"), PACK_FIRST_ID, random_value(1));
+    uint64_t unboxed = std::get <3>(last_action <loggetrand_args>(name("loggetrand")))[0];
+    EXPECT(unboxed > POOL_SLOTS && unboxed <= CONTENT_ASSETS);
+
+    opener.removeall("gencursor", 2, 1);
+    opener.removeall("availpacks", 0, CONTENT_ASSETS);
+    EXPECT(genpacks_added(opener) == CONTENT_ASSETS - POOL_SLOTS - 1);
+    EXPECT_FAIL(opener.addpack(2, {unboxed}));
+
+    //Once claimed the asset leaves the index, its neighbours stay in it
+    opener.claimunboxed(PACK_FIRST_ID);
+    opener.addpack(2, {unboxed});
+    if (unboxed > POOL_SLOTS + 1) {
+        EXPECT_FAIL(opener.addpack(2, {unboxed - 1}));
+    }
+    if (unboxed < CONTENT_ASSETS) {
+        EXPECT_FAIL(opener.addpack(2, {unboxed + 1}));
+    }
+
+    //Assets outside of every pool and bundle can be added, also inside one bundle next to each other
+    opener.addpacks(2, {{CONTENT_ASSETS + 2, CONTENT_ASSETS + 1}, {CONTENT_ASSETS + 3}});
+    EXPECT_FAIL(opener.addpack(2, {CONTENT_ASSETS + 4, CONTENT_ASSETS + 4}));
+    EXPECT_FAIL(opener.addpack(2, {CONTENT_ASSETS + 2}));
+
+    return failures;
+}
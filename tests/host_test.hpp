@@ -0,0 +1,108 @@
+#pragma once
+
+/**
+ * Helpers shared by the host tests
+ *
+ * Every test is a plain program that drives the contract through its actions on the host chain and
+ * inspects the inline actions it captured. EXPECT records a failure and carries on, the program
+ * returns the number of failed expectations so ctest reports it.
+ */
+
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <packsopener.hpp>
+
+namespace host_test {
+
+    static const name SELF = CONTRACTN;
+    static const name ORNG = name("orng.wax");
+    static const name COLLECTION = name("clashdomenft");
+
+    //loggetrand arguments: pack_asset_id, max_value, final_random_value, assets_ids
+    typedef std::tuple <uint64_t, uint64_t, uint64_t, vector <uint64_t>> loggetrand_args;
+    //logrolls arguments: pack_asset_id, unboxer, template_ids
+    typedef std::tuple <uint64_t, name, vector <int32_t>> logrolls_args;
+
+    inline int failures = 0;
+
+    #define EXPECT(cond) \
+        do { \
+            if (!(cond)) { \
+                fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #cond); \
+                host_test::failures++; \
+            } \
+        } while (0)
+
+    #define EXPECT_FAIL(stmt) \
+        do { \
+            bool failed = false; \
+            try { \
+                stmt; \
+            } catch (const host::assert_exception &) { \
+                failed = true; \
+            } \
+            if (!failed) { \
+                fprintf(stderr, "%s:%d: expected %s to fail\n", __FILE__, __LINE__, #stmt); \
+                host_test::failures++; \
+            } \
+        } while (0)
+
+    //Empties the chain and returns a contract authorized within COLLECTION
+    inline packsopener setup() {
+        auto &chain = host::get_chain();
+        chain.reset();
+
+        atomicassets::collections.emplace(SELF, [&](auto &_collection) {
+            _collection.collection_name = COLLECTION;
+            _collection.author = SELF;
+            _collection.authorized_accounts = {SELF};
+        });
+
+        return packsopener(SELF, SELF, datastream <const char *>(nullptr, 0));
+    }
+
+    inline void add_asset(uint64_t asset_id, name schema_name, int32_t template_id) {
+        atomicassets::assets_t own_assets = atomicassets::get_assets(SELF);
+        own_assets.emplace(SELF, [&](auto &_asset) {
+            _asset.asset_id = asset_id;
+            _asset.collection_name = COLLECTION;
+            _asset.schema_name = schema_name;
+            _asset.template_id = template_id;
+            _asset.ram_payer = SELF;
+        });
+    }
+
+    inline checksum256 random_value(uint64_t seed) {
+        return eosio::sha256((const char *) &seed, sizeof(seed));
+    }
+
+    //Arguments of the last inline action with the given name, which needs to exist
+    template <typename T>
+    const T &last_action(name action_name) {
+        const auto &actions = host::get_chain().actions;
+        for (auto itr = actions.rbegin(); itr != actions.rend(); itr++) {
+            if (itr->action_name == action_name) {
+                return itr->as <T>();
+            }
+        }
+        throw std::runtime_error("No " + action_name.to_string() + " action was sent");
+    }
+
+    //Transfers the pack asset to the contract and resolves it with the given random value
+    inline void unbox(packsopener &opener, name unboxer, uint64_t pack_asset_id, const checksum256 &random) {
+        auto &chain = host::get_chain();
+        chain.actions.clear();
+
+        chain.set_auth({});
+        opener.receive_asset_transfer(unboxer, SELF, {pack_asset_id}, "unbox");
+
+        chain.set_auth({ORNG});
+        opener.receiverand(pack_asset_id, random);
+
+        chain.set_auth({SELF});
+    }
+
+} // namespace host_test
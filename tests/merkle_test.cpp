@@ -0,0 +1,105 @@
+/**
+ * Merkle packs are claimed with the proof of the drawn leaf, tampered proofs are refused
+ */
+
+#include "host_test.hpp"
+
+using namespace host_test;
+
+static const int32_t PACK_TEMPLATE_ID = 100001;
+static const uint64_t PACK_FIRST_ID = 1ULL << 40;
+static const uint64_t PACK_ID = 1;
+
+//transfer arguments: from, to, assets_ids, memo
+typedef std::tuple <name, name, vector <uint64_t>, string> transfer_args;
+
+//Hashes of the tree as documented on setpackroot, written out independently of the contract
+static checksum256 leaf_hash(uint64_t leaf_index, const vector <uint64_t> &assets_ids) {
+    vector <uint8_t> buf = {0};
+    auto write = [&](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            buf.push_back((uint8_t) (value >> (8 * i)));
+        }
+    };
+
+    write(PACK_ID);
+    write(leaf_index);
+    for (uint64_t asset_id : assets_ids) {
+        write(asset_id);
+    }
+    return eosio::sha256((const char *) buf.data(), buf.size());
+}
+
+static checksum256 node_hash(const checksum256 &left, const checksum256 &right) {
+    vector <uint8_t> buf = {1};
+    buf.insert(buf.end(), left.data(), left.data() + 32);
+    buf.insert(buf.end(), right.data(), right.data() + 32);
+    return eosio::sha256((const char *) buf.data(), buf.size());
+}
+
+int main() {
+    packsopener opener = setup();
+    auto &chain = host::get_chain();
+
+    //5 leaves padded with zero hashes to 8
+    vector <vector <uint64_t>> bundles = {{100, 101}, {102}, {103, 104, 105}, {106}, {107}};
+
+    vector <vector <checksum256>> levels(1);
+    for (uint64_t i = 0; i < 8; i++) {
+        levels[0].push_back(i < bundles.size() ? leaf_hash(i, bundles[i]) : checksum256());
+    }
+    while (levels.back().size() > 1) {
+        vector <checksum256> level;
+        for (uint64_t i = 0; i < levels.back().size(); i += 2) {
+            level.push_back(node_hash(levels.back()[i], levels.back()[i + 1]));
+        }
+        levels.push_back(level);
+    }
+
+    chain.set_auth({SELF});
+    opener.createpack(SELF, COLLECTION, 0, PACK_TEMPLATE_ID, "");
+    opener.setpackroot(PACK_ID, levels.back()[0], bundles.size());
+
+    vector <bool> claimed(bundles.size(), false);
+
+    for (uint64_t i = 0; i < bundles.size(); i++) {
+        uint64_t pack_asset_id = PACK_FIRST_ID + i;
+        add_asset(pack_asset_id, name("packs"), PACK_TEMPLATE_ID);
+        unbox(opener, name("alice"), pack_asset_id, random_value(i));
+
+        uint64_t leaf = std::get <2>(last_action <loggetrand_args>(name("loggetrand")));
+        EXPECT(leaf < bundles.size());
+        if (leaf >= bundles.size()) {
+            continue;
+        }
+        EXPECT(!claimed[leaf]);
+        claimed[leaf] = true;
+
+        vector <checksum256> proof;
+        for (uint64_t level = 0, index = leaf; level + 1 < levels.size(); level++, index /= 2) {
+            proof.push_back(levels[level][index ^ 1]);
+        }
+
+        vector <uint64_t> other_assets = bundles[(leaf + 1) % bundles.size()];
+        EXPECT_FAIL(opener.claimproof(pack_asset_id, other_assets, proof));
+
+        vector <checksum256> tampered = proof;
+        tampered[0].data()[0] ^= 1;
+        EXPECT_FAIL(opener.claimproof(pack_asset_id, bundles[leaf], tampered));
+
+        vector <checksum256> short_proof(proof.begin(), proof.end() - 1);
+        EXPECT_FAIL(opener.claimproof(pack_asset_id, bundles[leaf], short_proof));
+
+        chain.actions.clear();
+        opener.claimproof(pack_asset_id, bundles[leaf], proof);
+
+        const auto &transfer = last_action <transfer_args>(name("transfer"));
+        EXPECT(std::get <1>(transfer) == name("alice"));
+        EXPECT(std::get <2>(transfer) == bundles[leaf]);
+
+        //the unbox is gone once claimed
+        EXPECT_FAIL(opener.claimproof(pack_asset_id, bundles[leaf], proof));
+    }
+
+    return failures;
+}
@@ -0,0 +1,89 @@
+/**
+ * Rolls drawn from the Walker alias table give each outcome with the frequency of its odds
+ */
+
+#include <cmath>
+#include <map>
+
+#include "host_test.hpp"
+
+using namespace host_test;
+
+static const int32_t PACK_TEMPLATE_ID = 100001;
+static const uint64_t PACK_FIRST_ID = 1ULL << 40;
+static const uint64_t UNBOXES = 20000;
+
+static void add_template(int32_t template_id) {
+    atomicassets::templates_t collection_templates = atomicassets::get_templates(COLLECTION);
+    collection_templates.emplace(SELF, [&](auto &_template) {
+        _template.template_id = template_id;
+        _template.schema_name = name("poolhalls");
+        _template.transferable = true;
+        _template.burnable = true;
+        _template.max_supply = 0;
+        _template.issued_supply = 0;
+    });
+}
+
+int main() {
+    packsopener opener = setup();
+    auto &chain = host::get_chain();
+
+    for (int32_t template_id = 1; template_id <= 4; template_id++) {
+        add_template(template_id);
+    }
+
+    chain.set_auth({SELF});
+    opener.createpack(SELF, COLLECTION, 0, PACK_TEMPLATE_ID, "");
+
+    //Odds of very different sizes, so the table needs several alias steps
+    vector <packsopener::OUTCOME> first_roll = {{-1, 50}, {1, 5}, {2, 300}, {3, 645}};
+    vector <packsopener::OUTCOME> second_roll = {{4, 7}};
+    opener.addpackroll(1, first_roll);
+    opener.addpackroll(1, second_roll);
+
+    //Rolls and bundles are exclusive
+    EXPECT_FAIL(opener.addpack(1, {900}));
+
+    map <int32_t, uint64_t> counts;
+
+    for (uint64_t i = 0; i < UNBOXES; i++) {
+        add_asset(PACK_FIRST_ID + i, name("packs"), PACK_TEMPLATE_ID);
+        unbox(opener, name("alice"), PACK_FIRST_ID + i, random_value(i));
+
+        const vector <int32_t> &template_ids = std::get <2>(last_action <logrolls_args>(name("logrolls")));
+        EXPECT(template_ids.size() == 2);
+        if (template_ids.size() != 2) {
+            continue;
+        }
+
+        counts[template_ids[0]]++;
+        EXPECT(template_ids[1] == 4);
+    }
+
+    uint64_t total_odds = 0;
+    for (const auto &outcome : first_roll) {
+        total_odds += outcome.odds;
+    }
+
+    //Within 5 standard deviations of the expected count
+    for (const auto &outcome : first_roll) {
+        double p = (double) outcome.odds / total_odds;
+        double expected = p * UNBOXES;
+        double deviation = std::sqrt(UNBOXES * p * (1 - p));
+        double count = (double) counts[outcome.template_id];
+
+        EXPECT(std::fabs(count - expected) <= 5 * deviation);
+        if (std::fabs(count - expected) > 5 * deviation) {
+            fprintf(stderr, "template %d: %.0f draws, expected %.0f\n", outcome.template_id, count, expected);
+        }
+    }
+
+    uint64_t drawn = 0;
+    for (const auto &count : counts) {
+        drawn += count.second;
+    }
+    EXPECT(drawn == UNBOXES);
+
+    return failures;
+}
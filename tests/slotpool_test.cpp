@@ -0,0 +1,73 @@
+/**
+ * Slot pools hand out every slot exactly once, across the chunks of the bitmap,
+ * and a pool set up again after removeall starts from empty slots
+ */
+
+#include <set>
+
+#include "host_test.hpp"
+
+using namespace host_test;
+
+static const int32_t PACK_TEMPLATE_ID = 100001;
+static const uint64_t PACK_FIRST_ID = 1ULL << 40;
+static const uint64_t POOL_FIRST_ID = 10000;
+static const uint64_t SLOT_COUNT = 2500;    // three chunks, the last one partly used
+static const uint64_t ASSETS_PER_SLOT = 2;
+
+int main() {
+    packsopener opener = setup();
+    auto &chain = host::get_chain();
+
+    chain.set_auth({SELF});
+    opener.createpack(SELF, COLLECTION, 0, PACK_TEMPLATE_ID, "");
+    opener.setslotpool(1, POOL_FIRST_ID, SLOT_COUNT, ASSETS_PER_SLOT);
+
+    set <uint64_t> slots;
+    set <uint64_t> chunks;
+    uint64_t pack_asset_id = PACK_FIRST_ID;
+
+    for (uint64_t i = 0; i < SLOT_COUNT; i++, pack_asset_id++) {
+        add_asset(pack_asset_id, name("packs"), PACK_TEMPLATE_ID);
+        unbox(opener, name("alice"), pack_asset_id, random_value(i));
+
+        const auto &args = last_action <loggetrand_args>(name("loggetrand"));
+        uint64_t slot = std::get <2>(args);
+        const vector <uint64_t> &assets_ids = std::get <3>(args);
+
+        EXPECT(slot < SLOT_COUNT);
+        EXPECT(slots.insert(slot).second);
+        EXPECT(assets_ids.size() == ASSETS_PER_SLOT);
+        EXPECT(assets_ids[0] == POOL_FIRST_ID + slot * ASSETS_PER_SLOT);
+        EXPECT(assets_ids[1] == assets_ids[0] + 1);
+
+        chunks.insert(slot / 1024);
+    }
+
+    EXPECT(slots.size() == SLOT_COUNT);
+    EXPECT(chunks.size() == 3);
+
+    add_asset(pack_asset_id, name("packs"), PACK_TEMPLATE_ID);
+    EXPECT_FAIL(unbox(opener, name("alice"), pack_asset_id, random_value(SLOT_COUNT)));
+    pack_asset_id++;
+
+    chain.set_auth({SELF});
+
+    //Every slot is used, the pool can only be set up again once its bitmap is gone
+    EXPECT_FAIL(opener.setslotpool(1, POOL_FIRST_ID, SLOT_COUNT, ASSETS_PER_SLOT));
+
+    opener.removeall("slotpools", 0, 1000);
+    opener.setslotpool(1, POOL_FIRST_ID, 10, 1);
+
+    slots.clear();
+    for (uint64_t i = 0; i < 10; i++, pack_asset_id++) {
+        add_asset(pack_asset_id, name("packs"), PACK_TEMPLATE_ID);
+        unbox(opener, name("bob"), pack_asset_id, random_value(SLOT_COUNT + i));
+
+        uint64_t slot = std::get <2>(last_action <loggetrand_args>(name("loggetrand")));
+        EXPECT(slot < 10);
+        EXPECT(slots.insert(slot).second);
+    }
+
+    return failures;
+}